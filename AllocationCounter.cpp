@@ -0,0 +1,115 @@
+#include "AllocationCounter.h"
+#include "AudioThreadTrap.h"
+#include <cstdlib>
+#include <new>
+
+#if ALLOCATION_COUNTER_REPLACES_NEW
+
+namespace
+{
+    // plain thread_local without a constructor, so it is safe to touch from inside operator new
+    thread_local juce::uint64 threadAllocations = 0;
+
+    void* allocateRaw(std::size_t size, std::size_t alignment) noexcept
+    {
+        if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            return std::malloc(size);
+
+       #if JUCE_WINDOWS
+        return _aligned_malloc(size, alignment);
+       #else
+        void* p = nullptr;
+        return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+       #endif
+    }
+
+    void freeRaw(void* p, std::size_t alignment) noexcept
+    {
+       #if JUCE_WINDOWS
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            _aligned_free(p);
+            return;
+        }
+       #else
+        juce::ignoreUnused(alignment);
+       #endif
+
+        std::free(p);
+    }
+
+    void* allocate(std::size_t size, std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__) noexcept
+    {
+        ++threadAllocations;
+
+        // with the libc hooks, malloc reports it below
+       #if !AUDIO_THREAD_TRAP_HOOKS_LIBC
+        AudioThreadTrap::check("operator new");
+       #endif
+
+        for (;;)
+        {
+            if (auto* p = allocateRaw(size == 0 ? 1 : size, alignment))
+                return p;
+
+            auto handler = std::get_new_handler();
+            if (handler == nullptr)
+                return nullptr;
+
+            handler();
+        }
+    }
+
+    void* allocateOrThrow(std::size_t size, std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        if (auto* p = allocate(size, alignment))
+            return p;
+
+        throw std::bad_alloc();
+    }
+}
+
+namespace AllocationCounter
+{
+    juce::uint64 getThreadCount() noexcept
+    {
+        return threadAllocations;
+    }
+}
+
+void* operator new(std::size_t size) { return allocateOrThrow(size); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+// over-aligned types, e.g. PlayerAudio through its cache-line aligned real-time state
+void* operator new(std::size_t size, std::align_val_t al) { return allocateOrThrow(size, (std::size_t)al); }
+void* operator new[](std::size_t size, std::align_val_t al) { return allocateOrThrow(size, (std::size_t)al); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return allocate(size, (std::size_t)al); }
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return allocate(size, (std::size_t)al); }
+
+void operator delete(void* p, std::align_val_t al) noexcept { freeRaw(p, (std::size_t)al); }
+void operator delete[](void* p, std::align_val_t al) noexcept { freeRaw(p, (std::size_t)al); }
+void operator delete(void* p, std::size_t, std::align_val_t al) noexcept { freeRaw(p, (std::size_t)al); }
+void operator delete[](void* p, std::size_t, std::align_val_t al) noexcept { freeRaw(p, (std::size_t)al); }
+void operator delete(void* p, std::align_val_t al, const std::nothrow_t&) noexcept { freeRaw(p, (std::size_t)al); }
+void operator delete[](void* p, std::align_val_t al, const std::nothrow_t&) noexcept { freeRaw(p, (std::size_t)al); }
+
+#else
+
+namespace AllocationCounter
+{
+    juce::uint64 getThreadCount() noexcept
+    {
+        return 0;
+    }
+}
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Replacing the global operator new is for benchmark and debug builds only: define
+// ALLOCATION_COUNTER_REPLACES_NEW=1 to compile the replacements in. Off by default, so a
+// shipping build allocates as usual and nothing is counted.
+#ifndef ALLOCATION_COUNTER_REPLACES_NEW
+ #define ALLOCATION_COUNTER_REPLACES_NEW 0
+#endif
+
+// Counts heap allocations per thread. With the replacements compiled in, everything allocated through
+// operator new is counted, over-aligned allocations included: containers, juce::String, make_unique
+// and so on. Direct calls to malloc are not. It also feeds the AudioThreadTrap.
+namespace AllocationCounter
+{
+	// whether the replacements are compiled in; if not, getThreadCount() stays 0
+	constexpr bool isCounting = ALLOCATION_COUNTER_REPLACES_NEW != 0;
+
+	// allocations the calling thread has made since it started
+	juce::uint64 getThreadCount() noexcept;
+}
@@ -0,0 +1,222 @@
+#include "AudioThreadTrap.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <execinfo.h>
+#elif JUCE_WINDOWS
+ #include <windows.h>
+#endif
+
+#if AUDIO_THREAD_TRAP_HOOKS_LIBC
+ #include <dlfcn.h>
+ #include <errno.h>
+ #include <pthread.h>
+#endif
+
+namespace
+{
+    std::atomic<bool> enabled{ false };
+    std::atomic<int> violations{ 0 };
+
+    // plain thread_locals without constructors, so the hooks can touch them at any time
+    thread_local bool insideCallback = false;
+    thread_local bool reporting = false;
+
+    // Stacks already logged, by hash; fixed size, so telling a repeat from a new one doesn't allocate.
+    // Once it is full, new stacks are still counted but no longer logged.
+    constexpr int maxReportedStacks = 1024;
+    std::atomic<juce::uint64> reportedStacks[maxReportedStacks]{};
+
+    constexpr int maxFrames = 48;
+
+    int captureStack(void** frames) noexcept
+    {
+       #if JUCE_LINUX || JUCE_MAC
+        return backtrace(frames, maxFrames);
+       #elif JUCE_WINDOWS
+        return (int)CaptureStackBackTrace(0, maxFrames, frames, nullptr);
+       #else
+        juce::ignoreUnused(frames);
+        return 0;
+       #endif
+    }
+
+    // true the first time this stack turns up
+    bool isNewStack(void* const* frames, int numFrames) noexcept
+    {
+        juce::uint64 hash = 14695981039346656037ull;
+        for (int i = 0; i < numFrames; ++i)
+            hash = (hash ^ (juce::uint64)(juce::pointer_sized_uint)frames[i]) * 1099511628211ull;
+        hash |= 1; // 0 marks a free slot
+
+        for (int i = 0; i < maxReportedStacks; ++i)
+        {
+            auto& slot = reportedStacks[((int)(hash % maxReportedStacks) + i) % maxReportedStacks];
+            juce::uint64 expected = 0;
+            if (slot.compare_exchange_strong(expected, hash))
+                return true;
+            if (expected == hash)
+                return false;
+        }
+
+        return false;
+    }
+
+    void report(const char* what)
+    {
+        // the same stack turns up every block; only the first time is logged, which allocates
+        void* frames[maxFrames];
+        if (!isNewStack(frames, captureStack(frames)))
+            return;
+
+        juce::Logger::writeToLog(juce::String("Audio thread violation: ") + what + "\n" + juce::SystemStats::getStackBacktrace());
+    }
+}
+
+namespace AudioThreadTrap
+{
+    void setEnabled(bool shouldBeEnabled) noexcept
+    {
+        enabled = shouldBeEnabled;
+    }
+
+    bool isEnabled() noexcept
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    int getViolationCount() noexcept
+    {
+        return violations.load(std::memory_order_relaxed);
+    }
+
+    ScopedCallback::ScopedCallback() noexcept
+        : wasInside(insideCallback)
+    {
+        insideCallback = true;
+    }
+
+    ScopedCallback::~ScopedCallback()
+    {
+        insideCallback = wasInside;
+    }
+
+    void check(const char* what) noexcept
+    {
+        if (!insideCallback || reporting || !enabled.load(std::memory_order_relaxed))
+            return;
+
+        // the report allocates and locks itself
+        reporting = true;
+        violations.fetch_add(1, std::memory_order_relaxed);
+
+        try
+        {
+            report(what);
+        }
+        catch (...)
+        {
+        }
+
+        reporting = false;
+    }
+}
+
+#if AUDIO_THREAD_TRAP_HOOKS_LIBC
+namespace
+{
+    using LockFunction = int (*)(pthread_mutex_t*);
+
+    // constant-initialised, so no guard lock is taken on the first call
+    std::atomic<LockFunction> realLock{ nullptr };
+
+    // resolved before main, so the hook itself never calls into the dynamic linker once the app runs
+    __attribute__((constructor(101))) void resolveRealLock()
+    {
+        if (realLock.load() == nullptr)
+            realLock.store((LockFunction)dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    }
+}
+
+// glibc lets the executable replace its allocator and mutex functions; these forward to the real ones
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* p, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void* __libc_valloc(size_t size);
+    void* __libc_pvalloc(size_t size);
+
+    void* malloc(size_t size)
+    {
+        AudioThreadTrap::check("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        AudioThreadTrap::check("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* p, size_t size)
+    {
+        AudioThreadTrap::check("realloc");
+        return __libc_realloc(p, size);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        AudioThreadTrap::check("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        AudioThreadTrap::check("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size)
+    {
+        AudioThreadTrap::check("posix_memalign");
+
+        if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0 || alignment == 0)
+            return EINVAL;
+
+        auto* p = __libc_memalign(alignment, size);
+        if (p == nullptr)
+            return ENOMEM;
+
+        *result = p;
+        return 0;
+    }
+
+    void* valloc(size_t size)
+    {
+        AudioThreadTrap::check("valloc");
+        return __libc_valloc(size);
+    }
+
+    void* pvalloc(size_t size)
+    {
+        AudioThreadTrap::check("pvalloc");
+        return __libc_pvalloc(size);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        // only a library initialised before our constructor can get here first, and that is before
+        // any audio thread exists
+        auto lockFunction = realLock.load(std::memory_order_relaxed);
+        if (lockFunction == nullptr)
+        {
+            resolveRealLock();
+            lockFunction = realLock.load();
+        }
+
+        AudioThreadTrap::check("pthread_mutex_lock");
+        return lockFunction(mutex);
+    }
+}
+#endif
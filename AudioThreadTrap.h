@@ -0,0 +1,42 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Whether malloc and its relatives (calloc, realloc and the aligned allocators) and pthread_mutex_lock
+// are hooked too. They can only be interposed with glibc, and replacing malloc for the whole process
+// is left to debug builds.
+#ifndef AUDIO_THREAD_TRAP_HOOKS_LIBC
+ #if JUCE_LINUX && defined(__GLIBC__) && JUCE_DEBUG
+  #define AUDIO_THREAD_TRAP_HOOKS_LIBC 1
+ #else
+  #define AUDIO_THREAD_TRAP_HOOKS_LIBC 0
+ #endif
+#endif
+
+// Debug mode that reports what the audio callback must not do: allocate, or lock a mutex.
+// Each violation is logged with a stack trace through juce::Logger, once per distinct stack.
+// operator new is hooked where ALLOCATION_COUNTER_REPLACES_NEW is set (see AllocationCounter.h);
+// malloc and mutexes where AUDIO_THREAD_TRAP_HOOKS_LIBC is set. Off by default, and cheap when off.
+namespace AudioThreadTrap
+{
+	void setEnabled(bool shouldBeEnabled) noexcept;
+	bool isEnabled() noexcept;
+
+	// violations since the start, counting repeats of the same stack
+	int getViolationCount() noexcept;
+
+	// Marks the calling thread as inside the audio callback while it exists
+	class ScopedCallback
+	{
+	public:
+		ScopedCallback() noexcept;
+		~ScopedCallback();
+
+	private:
+		const bool wasInside;
+
+		JUCE_DECLARE_NON_COPYABLE(ScopedCallback)
+	};
+
+	// Called by the hooks: reports what happened if the calling thread is inside the callback
+	void check(const char* what) noexcept;
+}
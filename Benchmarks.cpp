@@ -0,0 +1,528 @@
+#include "Benchmarks.h"
+#include "AllocationCounter.h"
+#include "MixerEngine.h"
+#include "MixKernels.h"
+#include "OfflineRenderer.h"
+#include "SincResampler.h"
+#include "TimeStretchSource.h"
+#include <iostream>
+
+namespace
+{
+    void print(const juce::String& line)
+    {
+        std::cout << line << std::endl;
+    }
+
+    // Runs the body repeatedly and returns the median time of one call in microseconds
+    template <typename Body>
+    double timeMedian(int numCalls, Body&& body)
+    {
+        std::vector<double> times;
+        times.reserve((size_t)numCalls);
+
+        for (int i = 0; i < numCalls; ++i)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            body(i);
+            const auto end = juce::Time::getHighResolutionTicks();
+            times.push_back(juce::Time::highResolutionTicksToSeconds(end - start) * 1.0e6);
+        }
+
+        std::nth_element(times.begin(), times.begin() + numCalls / 2, times.end());
+        return times[(size_t)numCalls / 2];
+    }
+
+    void fillWithNoise(juce::AudioBuffer<float>& buffer, juce::Random& random)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(ch, i, random.nextFloat() * 2.0f - 1.0f);
+    }
+
+    // Writes a 16 bit test file of our own, so runs don't depend on what is on disk
+    bool writeTestFile(const juce::File& file, juce::AudioFormat& format, const juce::AudioBuffer<float>& audio, double sampleRate)
+    {
+        std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(
+            file.createOutputStream().release(), sampleRate, (unsigned int)audio.getNumChannels(), 16, {}, 0));
+
+        return writer != nullptr && writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+    }
+
+    // value below which this fraction of the sorted values lie
+    double percentile(const std::vector<double>& sorted, double fraction)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        return sorted[juce::jmin(sorted.size() - 1, (size_t)(fraction * (double)sorted.size()))];
+    }
+
+    // Total harmonic distortion plus noise of a sine of known frequency, in dB: everything left
+    // after a least-squares fit of the sine, relative to the sine
+    double measureThdPlusNoise(const std::vector<float>& signal, double frequency, double sampleRate)
+    {
+        const double w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        double ss = 0.0, cc = 0.0, sc = 0.0, ys = 0.0, yc = 0.0;
+
+        for (size_t i = 0; i < signal.size(); ++i)
+        {
+            const double s = std::sin(w * (double)i), c = std::cos(w * (double)i);
+            ss += s * s; cc += c * c; sc += s * c;
+            ys += signal[i] * s; yc += signal[i] * c;
+        }
+
+        const double det = ss * cc - sc * sc;
+        const double a = (ys * cc - yc * sc) / det;
+        const double b = (yc * ss - ys * sc) / det;
+
+        double residual = 0.0, fundamental = 0.0;
+        for (size_t i = 0; i < signal.size(); ++i)
+        {
+            const double fit = a * std::sin(w * (double)i) + b * std::cos(w * (double)i);
+            residual += (signal[i] - fit) * (signal[i] - fit);
+            fundamental += fit * fit;
+        }
+
+        return 10.0 * std::log10(juce::jmax(1.0e-30, residual) / fundamental);
+    }
+}
+
+namespace Benchmarks
+{
+    bool run(const juce::String& name)
+    {
+        const bool all = name.isEmpty() || name == "all";
+        bool found = false;
+
+        if (all || name == "mix")
+        {
+            runMixBus();
+            found = true;
+        }
+
+        if (all || name == "stretch")
+        {
+            runTimeStretch();
+            found = true;
+        }
+
+        if (all || name == "resample")
+        {
+            runResampler();
+            found = true;
+        }
+
+        if (all || name == "render")
+        {
+            runOfflineRender();
+            found = true;
+        }
+
+        if (all || name == "chain")
+        {
+            runRenderChain();
+            found = true;
+        }
+
+        return found;
+    }
+
+    void runMixBus()
+    {
+        const int blockSize = 512;
+        const int numBlocks = 2000;
+        const double sampleRate = 48000.0;
+        const double blockDeadlineMicros = blockSize / sampleRate * 1.0e6;
+
+        print("Mix bus, " + juce::String(blockSize) + " stereo frames per block, kernels: "
+            + MixKernels::getImplementationName());
+        print("decks   ramped kernel (us/block)   gain pass + add (us/block)   kernel share of deadline");
+
+        juce::Random random(1234);
+
+        for (int numDecks : { 2, 8, 32 })
+        {
+            // every deck's block is different, as it would be with real tracks
+            std::vector<std::unique_ptr<juce::AudioBuffer<float>>> deckBlocks;
+            for (int d = 0; d < numDecks; ++d)
+            {
+                deckBlocks.push_back(std::make_unique<juce::AudioBuffer<float>>(2, blockSize));
+                fillWithNoise(*deckBlocks.back(), random);
+            }
+
+            juce::AudioBuffer<float> bus(2, blockSize);
+            juce::AudioBuffer<float> scratch(2, blockSize);
+
+            // both paths copy each deck's block into a scratch buffer first, standing in for the deck rendering it;
+            // worst case: every deck's gain is moving in every block
+            auto gainFor = [](int block, int deck) { return 0.5f + 0.25f * std::sin(0.01f * (float)(block + deck)); };
+
+            const double kernelMicros = timeMedian(numBlocks, [&](int block)
+                {
+                    bus.clear();
+                    for (int d = 0; d < numDecks; ++d)
+                    {
+                        const float start = gainFor(block, d);
+                        const float end = gainFor(block + 1, d);
+                        scratch.copyFrom(0, 0, *deckBlocks[(size_t)d], 0, 0, blockSize);
+                        scratch.copyFrom(1, 0, *deckBlocks[(size_t)d], 1, 0, blockSize);
+                        MixKernels::addRampedStereo(bus.getWritePointer(0), bus.getWritePointer(1),
+                            scratch.getReadPointer(0), scratch.getReadPointer(1), blockSize,
+                            start, end, start, end);
+                    }
+                });
+
+            // what MixerAudioSource with a per-deck gain ramp did: ramp in place, then a separate add
+            const double twoPassMicros = timeMedian(numBlocks, [&](int block)
+                {
+                    bus.clear();
+                    for (int d = 0; d < numDecks; ++d)
+                    {
+                        const float start = gainFor(block, d);
+                        const float end = gainFor(block + 1, d);
+                        scratch.copyFrom(0, 0, *deckBlocks[(size_t)d], 0, 0, blockSize);
+                        scratch.copyFrom(1, 0, *deckBlocks[(size_t)d], 1, 0, blockSize);
+                        scratch.applyGainRamp(0, blockSize, start, end);
+
+                        for (int ch = 0; ch < 2; ++ch)
+                            bus.addFrom(ch, 0, scratch, ch, 0, blockSize);
+                    }
+                });
+
+            print(juce::String(numDecks).paddedLeft(' ', 5)
+                + juce::String(kernelMicros, 2).paddedLeft(' ', 27)
+                + juce::String(twoPassMicros, 2).paddedLeft(' ', 29)
+                + juce::String(100.0 * kernelMicros / blockDeadlineMicros, 3).paddedLeft(' ', 26) + " %");
+        }
+    }
+}
+
+namespace Benchmarks
+{
+    void runTimeStretch()
+    {
+        const int blockSize = 512;
+        const int numBlocks = 2000;
+        const double sampleRate = 48000.0;
+        const double blockDeadlineMicros = blockSize / sampleRate * 1.0e6;
+
+        print("Time-stretch, " + juce::String(blockSize) + " stereo frames per block");
+        print("preset          tempo   us/block   share of deadline   latency (ms)");
+
+        const std::pair<TimeStretchSource::Quality, const char*> presets[] = {
+            { TimeStretchSource::Quality::lowLatency, "low latency" },
+            { TimeStretchSource::Quality::balanced, "balanced" },
+            { TimeStretchSource::Quality::highQuality, "high quality" }
+        };
+
+        for (const auto& preset : presets)
+        {
+            for (double tempo : { 0.8, 1.25 })
+            {
+                juce::ToneGeneratorAudioSource tone;
+                tone.setFrequency(440.0);
+                tone.setAmplitude(0.5f);
+
+                TimeStretchSource stretch(&tone);
+                stretch.prepareToPlay(blockSize, sampleRate);
+                stretch.setEnabled(true);
+                stretch.setQuality(preset.first);
+                stretch.setTempo(tempo);
+
+                juce::AudioBuffer<float> block(2, blockSize);
+                juce::AudioSourceChannelInfo info(&block, 0, blockSize);
+
+                const double micros = timeMedian(numBlocks, [&](int) { stretch.getNextAudioBlock(info); });
+
+                print(juce::String(preset.second).paddedRight(' ', 14)
+                    + juce::String(tempo, 2).paddedLeft(' ', 7)
+                    + juce::String(micros, 2).paddedLeft(' ', 11)
+                    + juce::String(100.0 * micros / blockDeadlineMicros, 3).paddedLeft(' ', 18) + " %"
+                    + juce::String(TimeStretchSource::getFrameSeconds(preset.first) * 1000.0, 1).paddedLeft(' ', 15));
+
+                stretch.releaseResources();
+            }
+        }
+    }
+}
+
+namespace Benchmarks
+{
+    void runResampler()
+    {
+        const int blockSize = 512;
+        const int numBlocks = 2000;
+        const double outputRate = 48000.0;
+        const double toneFrequency = 1000.0;
+        const double blockDeadlineMicros = blockSize / outputRate * 1.0e6;
+
+        print("Resampler, " + juce::String(blockSize) + " stereo frames per block at 48 kHz out, "
+            + juce::String(toneFrequency, 0) + " Hz tone");
+        print("case                 resampler   us/block   share of deadline   THD+N (dB)");
+
+        const std::pair<double, const char*> cases[] = {
+            { 44100.0 / 48000.0, "44.1k -> 48k" },
+            { 48000.0 / 44100.0, "48k -> 44.1k" },
+            { 0.5, "2x up" },
+            { 2.0, "2x down" },
+            { 1.1 * 44100.0 / 48000.0, "44.1k at 1.1x" },
+            { 0.8, "48k at 0.8x" }
+        };
+
+        auto measure = [&](juce::AudioSource& resampler, const char* caseName, const char* resamplerName)
+            {
+                juce::AudioBuffer<float> block(2, blockSize);
+                juce::AudioSourceChannelInfo info(&block, 0, blockSize);
+
+                // distortion over one second of output once the filters have filled
+                std::vector<float> output;
+                for (int i = 0; i < 8; ++i)
+                    resampler.getNextAudioBlock(info);
+                for (int i = 0; i < (int)outputRate / blockSize; ++i)
+                {
+                    resampler.getNextAudioBlock(info);
+                    output.insert(output.end(), block.getReadPointer(0), block.getReadPointer(0) + blockSize);
+                }
+
+                const double micros = timeMedian(numBlocks, [&](int) { resampler.getNextAudioBlock(info); });
+
+                print(juce::String(caseName).paddedRight(' ', 19)
+                    + juce::String(resamplerName).paddedLeft(' ', 12)
+                    + juce::String(micros, 2).paddedLeft(' ', 11)
+                    + juce::String(100.0 * micros / blockDeadlineMicros, 3).paddedLeft(' ', 18) + " %"
+                    + juce::String(measureThdPlusNoise(output, toneFrequency, outputRate), 1).paddedLeft(' ', 13));
+            };
+
+        for (const auto& c : cases)
+        {
+            // both resamplers prepare the tone at 48 kHz * ratio, so it comes out at toneFrequency
+            {
+                juce::ToneGeneratorAudioSource tone;
+                tone.setFrequency(toneFrequency);
+                tone.setAmplitude(0.5f);
+
+                juce::ResamplingAudioSource standard(&tone, false, 2);
+                standard.setResamplingRatio(c.first);
+                standard.prepareToPlay(blockSize, outputRate);
+                measure(standard, c.second, "standard");
+                standard.releaseResources();
+            }
+            {
+                juce::ToneGeneratorAudioSource tone;
+                tone.setFrequency(toneFrequency);
+                tone.setAmplitude(0.5f);
+
+                SincResamplingSource sinc(&tone);
+                sinc.setResamplingRatio(c.first);
+                sinc.prepareToPlay(blockSize, outputRate);
+                measure(sinc, c.second, "sinc");
+                sinc.releaseResources();
+            }
+        }
+    }
+}
+
+namespace Benchmarks
+{
+    void runOfflineRender()
+    {
+        const double sampleRate = 44100.0;
+        const double fileSeconds = 30.0;
+
+        juce::TemporaryFile source(".wav");
+        {
+            juce::Random random(1234);
+            juce::AudioBuffer<float> noise(2, (int)(fileSeconds * sampleRate));
+            fillWithNoise(noise, random);
+            noise.applyGain(0.25f);
+
+            juce::WavAudioFormat wav;
+            if (!writeTestFile(source.getFile(), wav, noise, sampleRate))
+            {
+                print("Offline render: can't write the test file");
+                return;
+            }
+        }
+
+        print("Offline render, " + juce::String(fileSeconds, 0) + " s files at 44.1 kHz into 48 kHz, sinc resampler");
+        print("decks   threads   seconds   x real time   same as one thread");
+
+        for (int numDecks : { 1, 4, 8 })
+        {
+            std::vector<OfflineRenderer::DeckSetup> decks;
+            for (int d = 0; d < numDecks; ++d)
+            {
+                OfflineRenderer::DeckSetup deck;
+                deck.file = source.getFile();
+                deck.startSeconds = 0.5 * d;
+                deck.gain = 1.0f / (float)numDecks;
+                deck.speed = 1.0 + 0.02 * d;
+                decks.push_back(deck);
+            }
+
+            juce::AudioBuffer<float> reference;
+
+            for (int numThreads : { 1, juce::SystemStats::getNumCpus() })
+            {
+                OfflineRenderer::Settings settings;
+                settings.sampleRate = 48000.0;
+                settings.numThreads = numThreads;
+
+                OfflineRenderer renderer(decks, settings);
+                juce::AudioBuffer<float> mix;
+                const auto result = renderer.renderToBuffer(mix);
+                if (result.failed())
+                {
+                    print(result.getErrorMessage());
+                    return;
+                }
+
+                bool same = true;
+                if (numThreads == 1)
+                    reference = mix;
+                else
+                    for (int ch = 0; ch < 2 && same; ++ch)
+                        same = std::memcmp(mix.getReadPointer(ch), reference.getReadPointer(ch),
+                            sizeof(float) * (size_t)mix.getNumSamples()) == 0;
+
+                print(juce::String(numDecks).paddedLeft(' ', 5)
+                    + juce::String(numThreads).paddedLeft(' ', 10)
+                    + juce::String(renderer.getElapsedSeconds(), 2).paddedLeft(' ', 10)
+                    + juce::String(renderer.getRenderedSeconds() / renderer.getElapsedSeconds(), 1).paddedLeft(' ', 14)
+                    + juce::String(same ? "yes" : "NO").paddedLeft(' ', 21));
+            }
+        }
+    }
+}
+
+namespace Benchmarks
+{
+    void runRenderChain()
+    {
+        const int blockSize = 512;
+        const double sampleRate = 48000.0;
+        const double fileRate = 44100.0;
+        const double fileSeconds = 6.0;
+        const double renderSeconds = 8.0;
+        const int warmUpBlocks = 4;
+        const double blockDeadlineMicros = blockSize / sampleRate * 1.0e6;
+
+        // a tone over noise, so FLAC has something to decode; shorter than a run, so tracks end or wrap
+        juce::AudioBuffer<float> audio(2, (int)(fileSeconds * fileRate));
+        {
+            juce::Random random(1234);
+            fillWithNoise(audio, random);
+            audio.applyGain(0.1f);
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < audio.getNumSamples(); ++i)
+                    audio.addSample(ch, i, 0.3f * std::sin(juce::MathConstants<float>::twoPi * 220.0f * (float)i / (float)fileRate));
+        }
+
+        // JUCE has no MP3 encoder, so FLAC stands in for compressed files
+        juce::WavAudioFormat wav;
+        juce::FlacAudioFormat flac;
+        juce::TemporaryFile wavFile(".wav"), flacFile(".flac");
+
+        if (!writeTestFile(wavFile.getFile(), wav, audio, fileRate) || !writeTestFile(flacFile.getFile(), flac, audio, fileRate))
+        {
+            print("Render chain: can't write the test files");
+            return;
+        }
+
+        const std::pair<juce::File, const char*> fixtures[] = {
+            { wavFile.getFile(), "wav" },
+            { flacFile.getFile(), "flac" }
+        };
+
+        print("Render chain, " + juce::String(fileSeconds, 0) + " s 44.1 kHz files rendered for " + juce::String(renderSeconds, 0)
+            + " s at 48 kHz in " + juce::String(blockSize) + " frame blocks; files are read on the rendering thread");
+        print("format  loop  speed  decks   x real time   p50 (us)   p99 (us)   max (us)   max / deadline   allocs/block");
+
+        double worstAllocations = 0.0;
+
+        for (const auto& fixture : fixtures)
+        {
+            for (bool loop : { false, true })
+            {
+                for (double speed : { 0.25, 0.5, 0.75, 1.0, 1.25, 1.5, 2.0 })
+                {
+                    for (int numDecks : { 1, 2, 4, 8, 16, 32 })
+                    {
+                        MixerEngine mixer(numDecks);
+                        mixer.prepareToPlay(blockSize, sampleRate);
+
+                        bool loaded = true;
+                        for (int d = 0; d < numDecks && loaded; ++d)
+                        {
+                            auto& deck = mixer.getDeck(d);
+                            deck.setGain(1.0f / (float)numDecks);
+                            deck.setOfflineRendering(true);
+                            deck.setSpeed(speed);
+
+                            loaded = deck.loadFileDirect(fixture.first);
+
+                            // every deck reads a different part of the file
+                            deck.setLooping(loop);
+                            deck.setPosition(deck.secondsToSamples(std::fmod(0.37 * d, fileSeconds)));
+                            deck.start();
+                        }
+
+                        if (!loaded)
+                        {
+                            print("Render chain: can't open the " + juce::String(fixture.second) + " file");
+                            return;
+                        }
+
+                        juce::AudioBuffer<float> block(2, blockSize);
+                        const juce::AudioSourceChannelInfo info(&block, 0, blockSize);
+                        const int numBlocks = (int)(renderSeconds * sampleRate / blockSize);
+
+                        for (int i = 0; i < warmUpBlocks; ++i)
+                            mixer.getNextAudioBlock(info);
+
+                        std::vector<double> times;
+                        times.reserve((size_t)numBlocks);
+
+                        const auto allocationsBefore = AllocationCounter::getThreadCount();
+                        for (int i = 0; i < numBlocks; ++i)
+                        {
+                            const auto start = juce::Time::getHighResolutionTicks();
+                            mixer.getNextAudioBlock(info);
+                            const auto end = juce::Time::getHighResolutionTicks();
+                            times.push_back(juce::Time::highResolutionTicksToSeconds(end - start) * 1.0e6);
+                        }
+
+                        // the times vector was reserved up front, so these are the chain's own
+                        const double allocations = (double)(AllocationCounter::getThreadCount() - allocationsBefore) / numBlocks;
+                        worstAllocations = juce::jmax(worstAllocations, allocations);
+
+                        double totalMicros = 0.0;
+                        for (auto t : times)
+                            totalMicros += t;
+                        std::sort(times.begin(), times.end());
+
+                        print(juce::String(fixture.second).paddedRight(' ', 6)
+                            + juce::String(loop ? "on" : "off").paddedLeft(' ', 6)
+                            + juce::String(speed, 2).paddedLeft(' ', 7)
+                            + juce::String(numDecks).paddedLeft(' ', 7)
+                            + juce::String(numBlocks * blockDeadlineMicros / totalMicros, 1).paddedLeft(' ', 14)
+                            + juce::String(percentile(times, 0.5), 1).paddedLeft(' ', 11)
+                            + juce::String(percentile(times, 0.99), 1).paddedLeft(' ', 11)
+                            + juce::String(times.back(), 1).paddedLeft(' ', 11)
+                            + juce::String(100.0 * times.back() / blockDeadlineMicros, 1).paddedLeft(' ', 15) + " %"
+                            + (AllocationCounter::isCounting ? juce::String(allocations, 2) : juce::String("n/a")).paddedLeft(' ', 15));
+
+                        mixer.releaseResources();
+                    }
+                }
+            }
+        }
+
+        if (!AllocationCounter::isCounting)
+            print("Allocations weren't counted: build with ALLOCATION_COUNTER_REPLACES_NEW=1");
+        else
+            print(worstAllocations > 0.0 ? "The render path allocated; see the allocs/block column"
+                                         : "No allocations on the render path");
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Timing runs of the real-time code paths, started from the command line with "--benchmark <name>".
+// Results are printed to stdout.
+namespace Benchmarks
+{
+	// Runs the named benchmark ("all" runs every one); returns false if the name is unknown
+	bool run(const juce::String& name);
+
+	// Cost of the mix bus per block for 2, 8 and 32 decks, SIMD kernels against the old two-pass path
+	void runMixBus();
+
+	// Cost per block and added latency of each time-stretch preset, slowed down and sped up
+	void runTimeStretch();
+
+	// Throughput and THD+N of JUCE's resampler against the polyphase sinc one at common ratios
+	void runResampler();
+
+	// Speed of the offline renderer on one thread and on all of them, and whether both give the same samples
+	void runOfflineRender();
+
+	// The whole deck chain driven through the mixer as a device would: WAV and FLAC files, speeds across
+	// the speed slider's range, looping on and off, 1 to 32 decks. Prints throughput, per-block time
+	// percentiles and heap allocations per block on the rendering thread.
+	void runRenderChain();
+}
@@ -0,0 +1,279 @@
+#include "CallbackProfiler.h"
+
+namespace
+{
+    double ticksToMicros(juce::int64 ticks) noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    }
+
+    juce::String formatMicros(double micros)
+    {
+        return micros >= 1000.0 ? juce::String(micros / 1000.0, 2) + " ms" : juce::String(juce::roundToInt(micros)) + " us";
+    }
+}
+
+const char* CallbackProfiler::getStageName(Stage stage) noexcept
+{
+    switch (stage)
+    {
+        case Stage::decode:   return "decode";
+        case Stage::stretch:  return "stretch";
+        case Stage::resample: return "resample";
+        case Stage::gain:     return "gain";
+        case Stage::sum:      return "sum";
+    }
+    return "";
+}
+
+//==============================================================================
+void CallbackProfiler::StageTicks::add(const StageTicks& other) noexcept
+{
+    for (int i = 0; i < numStages; ++i)
+        ticks[i] += other.ticks[i];
+}
+
+juce::int64 CallbackProfiler::StageTicks::getTotal() const noexcept
+{
+    juce::int64 total = 0;
+    for (auto t : ticks)
+        total += t;
+    return total;
+}
+
+//==============================================================================
+void CallbackProfiler::Histogram::add(double micros) noexcept
+{
+    int bucket = 0;
+    if (micros >= 1.0)
+        bucket = juce::jmin(numBuckets - 1, 1 + (int)(std::log2(micros) * bucketsPerOctave));
+
+    // a single writer, so a plain load and store is enough and avoids a locked instruction
+    counts[bucket].store(counts[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if ((float)micros > maxMicros.load(std::memory_order_relaxed))
+        maxMicros.store((float)micros, std::memory_order_relaxed);
+}
+
+void CallbackProfiler::Histogram::clear() noexcept
+{
+    for (auto& count : counts)
+        count.store(0, std::memory_order_relaxed);
+    maxMicros.store(0.0f, std::memory_order_relaxed);
+}
+
+CallbackProfiler::Histogram::Counts CallbackProfiler::Histogram::read() const noexcept
+{
+    Counts copy;
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        copy.counts[i] = counts[i].load(std::memory_order_relaxed);
+        copy.total += copy.counts[i];
+    }
+    copy.maxMicros = maxMicros.load(std::memory_order_relaxed);
+    return copy;
+}
+
+double CallbackProfiler::Histogram::getBucketLimitMicros(int bucket) noexcept
+{
+    return std::exp2((double)bucket / bucketsPerOctave);
+}
+
+double CallbackProfiler::Histogram::Counts::getPercentileMicros(double fraction) const noexcept
+{
+    if (total == 0)
+        return 0.0;
+
+    const auto target = (juce::uint64)std::ceil(fraction * (double)total);
+    juce::uint64 sum = 0;
+
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        sum += counts[i];
+
+        // the last bucket is open ended, and no bucket reaches past the slowest duration
+        if (sum >= target)
+            return i == numBuckets - 1 ? (double)maxMicros : juce::jmin(getBucketLimitMicros(i), (double)maxMicros);
+    }
+
+    return (double)maxMicros;
+}
+
+//==============================================================================
+std::pair<int, CallbackProfiler::Stage> CallbackProfiler::BlockReport::findHeaviest() const noexcept
+{
+    std::pair<int, Stage> heaviest{ 0, Stage::decode };
+    float most = -1.0f;
+
+    for (int deck = 0; deck < numDecks; ++deck)
+        for (int stage = 0; stage < numStages; ++stage)
+            if (stageMicros[deck][stage] > most)
+            {
+                most = stageMicros[deck][stage];
+                heaviest = { deck, (Stage)stage };
+            }
+
+    return heaviest;
+}
+
+//==============================================================================
+CallbackProfiler::~CallbackProfiler()
+{
+    stopTimer();
+}
+
+void CallbackProfiler::setLogInterval(int seconds)
+{
+    if (seconds > 0)
+        startTimer(seconds * 1000);
+    else
+        stopTimer();
+}
+
+void CallbackProfiler::timerCallback()
+{
+    if (isEnabled() && getNumBlocks() > 0)
+        juce::Logger::writeToLog(getReport());
+}
+
+void CallbackProfiler::prepare(int numDecksToProfile, double newSampleRate) noexcept
+{
+    numDecks = juce::jlimit(0, maxDecks, numDecksToProfile);
+    sampleRate = newSampleRate;
+
+    // times from another device setup don't compare
+    clearAll();
+}
+
+void CallbackProfiler::clearAll() noexcept
+{
+    blockHistogram.clear();
+    for (auto& deck : stageHistograms)
+        for (auto& histogram : deck)
+            histogram.clear();
+
+    numBlocks = 0;
+    deadlineMisses = 0;
+    worstMicros = 0.0f;
+
+    worstBlock.getWriteBuffer() = {};
+    worstBlock.publish();
+    lastMiss.getWriteBuffer() = {};
+    lastMiss.publish();
+}
+
+void CallbackProfiler::beginBlock() noexcept
+{
+    blockActive = isEnabled() && sampleRate > 0.0;
+    if (!blockActive)
+        return;
+
+    if (resetRequested.exchange(false))
+        clearAll();
+
+    const int decks = getNumDecks();
+    for (int i = 0; i < decks; ++i)
+        blockStages[i].clear();
+
+    blockStartTicks = juce::Time::getHighResolutionTicks();
+}
+
+void CallbackProfiler::addDeck(int deck, const StageTicks& stageTicks) noexcept
+{
+    if (blockActive && deck < getNumDecks())
+        blockStages[deck].add(stageTicks);
+}
+
+void CallbackProfiler::endBlock(int numSamples) noexcept
+{
+    if (!blockActive)
+        return;
+
+    blockActive = false;
+
+    const auto micros = (float)ticksToMicros(juce::Time::getHighResolutionTicks() - blockStartTicks);
+    const auto deadline = (float)(numSamples * 1.0e6 / sampleRate);
+    const int decks = getNumDecks();
+
+    blockHistogram.add(micros);
+    for (int deck = 0; deck < decks; ++deck)
+        for (int stage = 0; stage < numStages; ++stage)
+            stageHistograms[deck][stage].add(ticksToMicros(blockStages[deck].ticks[stage]));
+
+    const auto blockNumber = numBlocks.load(std::memory_order_relaxed);
+    numBlocks.store(blockNumber + 1, std::memory_order_relaxed);
+    lastDeadlineMicros.store(deadline, std::memory_order_relaxed);
+
+    const bool missed = micros > deadline;
+    const bool slowest = micros > worstMicros;
+    if (!missed && !slowest)
+        return;
+
+    auto fillReport = [&](BlockReport& report)
+    {
+        report.blockNumber = blockNumber;
+        report.numSamples = numSamples;
+        report.numDecks = decks;
+        report.micros = micros;
+        report.deadlineMicros = deadline;
+
+        for (int deck = 0; deck < decks; ++deck)
+            for (int stage = 0; stage < numStages; ++stage)
+                report.stageMicros[deck][stage] = (float)ticksToMicros(blockStages[deck].ticks[stage]);
+    };
+
+    if (missed)
+    {
+        deadlineMisses.store(deadlineMisses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        fillReport(lastMiss.getWriteBuffer());
+        lastMiss.publish();
+    }
+
+    if (slowest)
+    {
+        worstMicros = micros;
+        fillReport(worstBlock.getWriteBuffer());
+        worstBlock.publish();
+    }
+}
+
+juce::String CallbackProfiler::getReport() const
+{
+    const auto blocks = blockHistogram.read();
+    const auto deadline = getLastDeadlineMicros();
+    const int decks = getNumDecks();
+
+    juce::StringArray lines;
+    lines.add("Audio callback: " + juce::String(getNumBlocks()) + " blocks, "
+        + juce::String(getDeadlineMisses()) + " deadline misses, deadline " + formatMicros(deadline));
+    lines.add("  block  p50 " + formatMicros(blocks.getPercentileMicros(0.5))
+        + "  p99 " + formatMicros(blocks.getPercentileMicros(0.99))
+        + "  max " + formatMicros(blocks.maxMicros));
+
+    auto describe = [](const char* name, const BlockReport& report)
+    {
+        if (report.blockNumber < 0)
+            return juce::String("  ") + name + ": none";
+
+        const auto [deck, stage] = report.findHeaviest();
+        return juce::String("  ") + name + ": block " + juce::String(report.blockNumber)
+            + ", " + formatMicros(report.micros) + " of " + formatMicros(report.deadlineMicros)
+            + ", mostly deck " + juce::String(deck + 1) + " " + getStageName(stage)
+            + " (" + formatMicros(report.stageMicros[deck][(int)stage]) + ")";
+    };
+
+    lines.add(describe("worst", getWorstBlock()));
+    lines.add(describe("last miss", getLastMiss()));
+
+    // p99 of each stage per deck
+    for (int deck = 0; deck < decks; ++deck)
+    {
+        juce::String line = "  deck " + juce::String(deck + 1) + " p99:";
+        for (int stage = 0; stage < numStages; ++stage)
+            line << "  " << getStageName((Stage)stage) << " "
+                 << formatMicros(stageHistograms[deck][stage].read().getPercentileMicros(0.99));
+        lines.add(line);
+    }
+
+    return lines.joinIntoString("\n");
+}
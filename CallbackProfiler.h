@@ -0,0 +1,153 @@
+#pragma once
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+// Times every audio block against its deadline, broken down by deck and stage.
+// The audio thread only bumps atomic histogram counters and publishes a breakdown through a
+// TripleBuffer when a block misses its deadline or is the slowest so far, so profiling never
+// waits on the message thread. Histograms, counters and reports can be read at any time.
+// While disabled, the mixer turns the decks' stage timing off too (see isTimingBlock()), so
+// nothing on the audio path reads the clock for it.
+class CallbackProfiler : private juce::Timer
+{
+public:
+	static constexpr int maxDecks = 32;
+
+	// Where a deck's time goes in one block
+	enum class Stage
+	{
+		decode,   // reading the track: a copy from the read-ahead, or decoding itself when mapped or offline
+		stretch,  // time-stretch
+		resample, // speed change and rate conversion
+		gain,     // fades, crossfades, metering and the rest of the deck's own block
+		sum       // the mix bus adding the deck onto the output
+	};
+
+	static constexpr int numStages = 5;
+	static const char* getStageName(Stage stage) noexcept;
+
+	// High-resolution ticks one deck spent in each stage
+	struct StageTicks
+	{
+		juce::int64 ticks[numStages] = {};
+
+		juce::int64& operator[](Stage stage) noexcept { return ticks[(int)stage]; }
+		juce::int64 operator[](Stage stage) const noexcept { return ticks[(int)stage]; }
+
+		void clear() noexcept { std::fill(std::begin(ticks), std::end(ticks), (juce::int64)0); }
+		void add(const StageTicks& other) noexcept;
+		juce::int64 getTotal() const noexcept;
+	};
+
+	// Counts of durations in quarter-octave buckets from 1 µs to about 1 s.
+	// One thread adds, any thread reads; counts are relaxed atomics, so a read may straddle a block.
+	class Histogram
+	{
+	public:
+		static constexpr int bucketsPerOctave = 4;
+		static constexpr int numBuckets = 20 * bucketsPerOctave + 1;
+
+		// A copy of the counts, for working out percentiles
+		struct Counts
+		{
+			juce::uint32 counts[numBuckets] = {};
+			juce::uint64 total = 0;
+			float maxMicros = 0.0f;
+
+			// upper bound of the bucket holding this fraction of the durations (0.99 = p99)
+			double getPercentileMicros(double fraction) const noexcept;
+		};
+
+		void add(double micros) noexcept;
+		void clear() noexcept;
+		Counts read() const noexcept;
+
+		// upper bound of a bucket in microseconds
+		static double getBucketLimitMicros(int bucket) noexcept;
+
+	private:
+		std::atomic<juce::uint32> counts[numBuckets]{};
+		std::atomic<float> maxMicros{ 0.0f };
+	};
+
+	// One block's time, per deck and stage
+	struct BlockReport
+	{
+		juce::int64 blockNumber = -1; // -1 if no block was recorded
+		int numSamples = 0;
+		int numDecks = 0;
+		float micros = 0.0f;
+		float deadlineMicros = 0.0f;
+		float stageMicros[maxDecks][numStages] = {};
+
+		// the deck and stage that took longest
+		std::pair<int, Stage> findHeaviest() const noexcept;
+	};
+
+	CallbackProfiler() = default;
+	~CallbackProfiler() override;
+
+	// Off by default; when off the audio thread skips all of the bookkeeping
+	void setEnabled(bool shouldBeEnabled) noexcept { enabled = shouldBeEnabled; }
+	bool isEnabled() const noexcept { return enabled.load(std::memory_order_relaxed); }
+
+	// Clears everything at the start of the next block
+	void reset() noexcept { resetRequested = true; }
+
+	// Writes getReport() to the juce::Logger every this many seconds while enabled; 0 stops
+	void setLogInterval(int seconds);
+
+	// Call from prepareToPlay, while nothing is rendering
+	void prepare(int numDecksToProfile, double sampleRate) noexcept;
+
+	// Audio thread: brackets one device block; the decks' times are added in between
+	void beginBlock() noexcept;
+	void addDeck(int deck, const StageTicks& stageTicks) noexcept;
+	void endBlock(int numSamples) noexcept;
+
+	// Audio thread: whether the block since beginBlock() is being timed, i.e. stage times are wanted
+	bool isTimingBlock() const noexcept { return blockActive; }
+
+	int getNumDecks() const noexcept { return numDecks.load(std::memory_order_relaxed); }
+	juce::int64 getNumBlocks() const noexcept { return numBlocks.load(std::memory_order_relaxed); }
+	juce::int64 getDeadlineMisses() const noexcept { return deadlineMisses.load(std::memory_order_relaxed); }
+	double getLastDeadlineMicros() const noexcept { return lastDeadlineMicros.load(std::memory_order_relaxed); }
+
+	const Histogram& getBlockHistogram() const noexcept { return blockHistogram; }
+	const Histogram& getStageHistogram(int deck, Stage stage) const noexcept { return stageHistograms[deck][(int)stage]; }
+
+	// Message thread only (each buffer has a single reader)
+	BlockReport getWorstBlock() const noexcept { return worstBlock.read(); }
+	BlockReport getLastMiss() const noexcept { return lastMiss.read(); }
+
+	// A few lines summing up the above; message thread only
+	juce::String getReport() const;
+
+private:
+	void timerCallback() override;
+	void clearAll() noexcept;
+
+	std::atomic<bool> enabled{ false };
+	std::atomic<bool> resetRequested{ false };
+
+	std::atomic<int> numDecks{ 0 };
+	double sampleRate = 0.0;
+
+	std::atomic<juce::int64> numBlocks{ 0 };
+	std::atomic<juce::int64> deadlineMisses{ 0 };
+	std::atomic<double> lastDeadlineMicros{ 0.0 };
+
+	Histogram blockHistogram;
+	Histogram stageHistograms[maxDecks][numStages];
+
+	// audio thread: the block being timed, and the slowest so far
+	bool blockActive = false;
+	juce::int64 blockStartTicks = 0;
+	StageTicks blockStages[maxDecks];
+	float worstMicros = 0.0f;
+
+	TripleBuffer<BlockReport> worstBlock;
+	TripleBuffer<BlockReport> lastMiss;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CallbackProfiler)
+};
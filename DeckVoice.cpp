@@ -0,0 +1,122 @@
+#include "DeckVoice.h"
+
+void DeckVoice::setSpeed(double newSpeed) noexcept
+{
+    speed = newSpeed;
+    updateRatio();
+}
+
+void DeckVoice::setKeepPitch(bool shouldKeepPitch) noexcept
+{
+    timeStretch.setEnabled(shouldKeepPitch);
+    standardResampler.flushBuffers();
+    sincResampler.flushBuffers();
+    updateRatio();
+}
+
+void DeckVoice::setResampler(Resampler newResampler) noexcept
+{
+    resampler = newResampler;
+    standardResampler.flushBuffers();
+    sincResampler.flushBuffers();
+}
+
+void DeckVoice::setPosition(juce::int64 position) noexcept
+{
+    trackQueue.setNextReadPosition(position);
+    flush();
+}
+
+void DeckVoice::flush() noexcept
+{
+    timeStretch.reset();
+    standardResampler.flushBuffers();
+    sincResampler.flushBuffers();
+}
+
+void DeckVoice::updateRatio() noexcept
+{
+    // with pitch kept the time-stretch changes the tempo and the resampler only converts the rate
+    timeStretch.setTempo(speed);
+    double ratio = timeStretch.isEnabled() ? 1.0 : speed;
+
+    // the file plays at its own rate, so convert to the device rate in the same step
+    auto* track = trackQueue.getCurrentTrack();
+    if (track != nullptr && deviceSampleRate > 0.0)
+        ratio *= track->sampleRate / deviceSampleRate;
+
+    // the time-stretch works on the file's samples, whatever rate the resamplers prepared it at
+    if (track != nullptr)
+        timeStretch.setInputSampleRate(track->sampleRate);
+
+    ratio = juce::jmin(ratio, maxRatio);
+    standardResampler.setResamplingRatio(ratio);
+    sincResampler.setResamplingRatio(ratio);
+}
+
+juce::int64 DeckVoice::getPlayedPosition() const noexcept
+{
+    return juce::jmax((juce::int64)0, trackQueue.getNextReadPosition() - timeStretch.getInputLead());
+}
+
+void DeckVoice::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    deviceSampleRate = sampleRate;
+
+    // JUCE's resampler grows its buffer in getNextAudioBlock when the ratio rises above the one it
+    // was prepared at. Prepared at the highest ratio, it also prepares the shared time-stretch and
+    // track queue once, for the most input a block can ask of them; the time-stretch rate this
+    // gives only sizes its buffers, and updateRatio() gives it the track's own rate.
+    // The sinc resampler only sizes its own history, for maxRatio whatever its current ratio.
+    standardResampler.setResamplingRatio(maxRatio);
+    standardResampler.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    sincResampler.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    updateRatio();
+}
+
+void DeckVoice::releaseResources()
+{
+    standardResampler.releaseResources();
+    sincResampler.releaseResources();
+}
+
+void DeckVoice::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    const auto startTicks = stageTiming ? juce::Time::getHighResolutionTicks() : 0;
+
+    if (resampler == Resampler::sinc)
+        sincResampler.getNextAudioBlock(bufferToFill);
+    else
+        standardResampler.getNextAudioBlock(bufferToFill);
+
+    if (!stageTiming)
+        return;
+
+    // each stage's time includes the stages it pulled from
+    const auto total = juce::Time::getHighResolutionTicks() - startTicks;
+    const auto decode = trackQueue.takeBusyTicks();
+    const auto stretch = timeStretch.takeBusyTicks();
+
+    using Stage = CallbackProfiler::Stage;
+    stageTicks[Stage::decode] += decode;
+    stageTicks[Stage::stretch] += stretch - decode;
+    stageTicks[Stage::resample] += total - stretch;
+}
+
+void DeckVoice::setStageTiming(bool shouldTime) noexcept
+{
+    stageTiming = shouldTime;
+    trackQueue.setTiming(shouldTime);
+    timeStretch.setTiming(shouldTime);
+
+    // nothing from before counts
+    trackQueue.takeBusyTicks();
+    timeStretch.takeBusyTicks();
+    stageTicks.clear();
+}
+
+void DeckVoice::takeStageTicks(CallbackProfiler::StageTicks& addTo) noexcept
+{
+    addTo.add(stageTicks);
+    stageTicks.clear();
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <JuceHeader.h>
+#include "CallbackProfiler.h"
+#include "SincResampler.h"
+#include "TimeStretchSource.h"
+#include "TrackQueueSource.h"
+
+// One playback chain of a deck: the track queue, the time-stretch and the resamplers after it.
+// A deck has two, so a newly loaded track can start on one while the old one fades out on the other.
+// The track queue's message-thread calls aside, everything except the constructor and
+// prepareToPlay is for the audio thread only.
+class DeckVoice : public juce::AudioSource
+{
+public:
+	// Highest resampling ratio, e.g. 8x speed on a file at twice the device rate. Both resamplers are
+	// sized for it in prepareToPlay, and higher ratios are capped, so changing speed never allocates.
+	static constexpr double maxRatio = 16.0;
+
+	// Which resampler does speed change and rate conversion: JUCE's, or the polyphase sinc one
+	enum class Resampler { standard, sinc };
+
+	// the handover is shared with the deck's other voice and must outlive this one
+	explicit DeckVoice(TrackHandover& handover) : trackQueue(handover) {}
+
+	TrackQueueSource& getTrackQueue() noexcept { return trackQueue; }
+	const TrackQueueSource& getTrackQueue() const noexcept { return trackQueue; }
+
+	void setSpeed(double newSpeed) noexcept;
+	void setKeepPitch(bool shouldKeepPitch) noexcept;
+	bool isKeepingPitch() const noexcept { return timeStretch.isEnabled(); }
+	void setStretchQuality(TimeStretchSource::Quality newQuality) noexcept { timeStretch.setQuality(newQuality); }
+	void setResampler(Resampler newResampler) noexcept;
+
+	// Moves the current track to a sample of the file and drops whatever was buffered before
+	void setPosition(juce::int64 position) noexcept;
+
+	// Drops everything buffered after the track queue, e.g. once the current track was swapped
+	void flush() noexcept;
+
+	// Resampling ratio for the current track's rate; call after swapping it
+	void updateRatio() noexcept;
+
+	// Sample of the file now being heard; the time-stretch reads ahead of it
+	juce::int64 getPlayedPosition() const noexcept;
+
+	float getStretchLoad() const noexcept { return timeStretch.getLastBlockLoad(); }
+
+	// Whether blocks are timed by stage; off unless the callback profiler is on
+	void setStageTiming(bool shouldTime) noexcept;
+
+	// Adds the decode, stretch and resample time of the blocks rendered since the last call
+	void takeStageTicks(CallbackProfiler::StageTicks& addTo) noexcept;
+
+	// AudioSource
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+	void releaseResources() override;
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+private:
+	TrackQueueSource trackQueue;
+	TimeStretchSource timeStretch{ &trackQueue };
+
+	// Both are kept at the same ratio and only the selected one is pulled. They share the
+	// time-stretch and track queue, which only JUCE's resampler prepares.
+	juce::ResamplingAudioSource standardResampler{ &timeStretch, false, 2 };
+	SincResamplingSource sincResampler{ &timeStretch, false };
+	Resampler resampler = Resampler::standard;
+
+	double speed = 1.0;
+	double deviceSampleRate = 0.0;
+
+	bool stageTiming = false;
+	CallbackProfiler::StageTicks stageTicks;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckVoice)
+};
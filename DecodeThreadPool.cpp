@@ -0,0 +1,78 @@
+#include "DecodeThreadPool.h"
+
+// Frees whatever it is handed, in the order it arrived
+class DecodeThreadPool::DisposalThread : public juce::Thread
+{
+public:
+    DisposalThread() : juce::Thread("Deck Disposal") {}
+
+    // anything still pending is freed with the member below, on the thread destroying the pool
+    ~DisposalThread() override { stopThread(2000); }
+
+    void add(std::shared_ptr<void> object)
+    {
+        {
+            const juce::ScopedLock sl(lock);
+            pending.push_back(std::move(object));
+        }
+        notify();
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            std::vector<std::shared_ptr<void>> toFree;
+            {
+                const juce::ScopedLock sl(lock);
+                toFree.swap(pending);
+            }
+
+            // the destructors run here, outside the lock
+            toFree.clear();
+            wait(-1);
+        }
+    }
+
+private:
+    juce::CriticalSection lock;
+    std::vector<std::shared_ptr<void>> pending;
+};
+
+DecodeThreadPool::DecodeThreadPool()
+{
+    // one thread per two cores, at least one and never more than four
+    const int numThreads = juce::jlimit(1, 4, juce::SystemStats::getNumCpus() / 2);
+
+    for (int i = 0; i < numThreads; ++i)
+    {
+        auto* thread = readAheadThreads.add(new juce::TimeSliceThread("Deck Read-Ahead " + juce::String(i + 1)));
+        thread->startThread(juce::Thread::Priority::high);
+    }
+
+    disposalThread = std::make_unique<DisposalThread>();
+    disposalThread->startThread(juce::Thread::Priority::low);
+}
+
+DecodeThreadPool::~DecodeThreadPool()
+{
+    jobs.removeAllJobs(true, 4000);
+
+    // readers being freed still unregister from their read-ahead thread
+    disposalThread.reset();
+
+    for (auto* thread : readAheadThreads)
+        thread->stopThread(2000);
+}
+
+juce::TimeSliceThread& DecodeThreadPool::getNextReadAheadThread()
+{
+    const int index = nextReadAheadThread.fetch_add(1) % readAheadThreads.size();
+    return *readAheadThreads[index];
+}
+
+void DecodeThreadPool::dispose(std::shared_ptr<void> object)
+{
+    if (object != nullptr)
+        disposalThread->add(std::move(object));
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Background threads shared by every deck.
+// Decks hold a juce::SharedResourcePointer to this so there is only one pool per process,
+// and each deck is given one of the read-ahead threads round-robin.
+// One-off work (opening the next track, parsing tags) goes to the job pool, and tracks the
+// audio thread has let go of are freed on a disposal thread.
+class DecodeThreadPool
+{
+public:
+	DecodeThreadPool();
+	~DecodeThreadPool();
+
+	// Read-ahead thread that a new deck should decode on
+	juce::TimeSliceThread& getNextReadAheadThread();
+
+	int getNumReadAheadThreads() const noexcept { return readAheadThreads.size(); }
+
+	// Pool for one-off background jobs
+	juce::ThreadPool& getJobPool() noexcept { return jobs; }
+
+	// Frees the object on the disposal thread, so closing a file or releasing a large buffer
+	// never stalls the thread that let go of it
+	void dispose(std::shared_ptr<void> object);
+
+private:
+	class DisposalThread;
+
+	juce::OwnedArray<juce::TimeSliceThread> readAheadThreads;
+	std::atomic<int> nextReadAheadThread{ 0 };
+
+	juce::ThreadPool jobs{ juce::jmax(2, juce::SystemStats::getNumCpus() - 1) };
+	std::unique_ptr<DisposalThread> disposalThread;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodeThreadPool)
+};
@@ -0,0 +1,40 @@
+#include "DspKernels.h"
+#include "SimdConfig.h"
+
+namespace DspKernels
+{
+    float dotProduct(const float* a, const float* b, int numSamples) noexcept
+    {
+        int i = 0;
+        float sum = 0.0f;
+
+       #if SIMD_KERNELS_AVX
+        __m256 acc = _mm256_setzero_ps();
+        for (; i + 8 <= numSamples; i += 8)
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+
+        const __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        const __m128 pairs = _mm_add_ps(half, _mm_movehl_ps(half, half));
+        sum = _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+       #elif SIMD_KERNELS_SSE2
+        __m128 acc = _mm_setzero_ps();
+        for (; i + 4 <= numSamples; i += 4)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+        const __m128 pairs = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        sum = _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+       #elif SIMD_KERNELS_NEON
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (; i + 4 <= numSamples; i += 4)
+            acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+
+        const float32x2_t pairs = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        sum = vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+       #endif
+
+        for (; i < numSamples; ++i)
+            sum += a[i] * b[i];
+
+        return sum;
+    }
+}
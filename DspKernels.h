@@ -0,0 +1,10 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Vectorised helpers for the deck's signal processing (time-stretch search, filters).
+// Compiled for the same instruction set as MixKernels, see SimdConfig.h.
+namespace DspKernels
+{
+	// sum of a[i] * b[i]
+	float dotProduct(const float* a, const float* b, int numSamples) noexcept;
+}
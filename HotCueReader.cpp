@@ -0,0 +1,116 @@
+#include "HotCueReader.h"
+
+const HotCueBank::Snippet* HotCueBank::findSnippet(juce::int64 position) const noexcept
+{
+    // last snippet starting at or before the position
+    auto it = std::upper_bound(snippets.begin(), snippets.end(), position,
+        [](juce::int64 pos, const SnippetPtr& s) { return pos < s->start; });
+
+    if (it == snippets.begin())
+        return nullptr;
+
+    const auto* snippet = std::prev(it)->get();
+    return position < snippet->start + snippet->audio.getNumSamples() ? snippet : nullptr;
+}
+
+std::unique_ptr<HotCueBank> HotCueBank::build(juce::AudioFormatReader& reader,
+    std::vector<juce::int64> cuePositions, int numSamples,
+    const std::vector<SnippetPtr>& reusable,
+    const std::function<bool()>& shouldExit)
+{
+    auto bank = std::make_unique<HotCueBank>();
+    bank->cues = std::move(cuePositions);
+    std::sort(bank->cues.begin(), bank->cues.end());
+
+    const int channels = (int)juce::jlimit(1u, 2u, reader.numChannels);
+
+    for (auto cue : bank->cues)
+    {
+        if (cue < 0 || cue >= reader.lengthInSamples)
+            continue;
+
+        // cues close together share the earlier snippet
+        if (!bank->snippets.empty() && bank->findSnippet(cue) != nullptr)
+            continue;
+
+        auto existing = std::find_if(reusable.begin(), reusable.end(),
+            [cue, numSamples](const SnippetPtr& s) { return s->start == cue && s->audio.getNumSamples() == numSamples; });
+
+        if (existing != reusable.end())
+        {
+            bank->snippets.push_back(*existing);
+            continue;
+        }
+
+        if (shouldExit && shouldExit())
+            return nullptr;
+
+        auto snippet = std::make_shared<Snippet>();
+        snippet->start = cue;
+        snippet->audio.setSize(channels, (int)juce::jmin((juce::int64)numSamples, reader.lengthInSamples - cue));
+        reader.read(&snippet->audio, 0, snippet->audio.getNumSamples(), cue, true, channels > 1);
+        bank->snippets.push_back(std::move(snippet));
+    }
+
+    return bank;
+}
+
+//==============================================================================
+HotCueReader::HotCueReader(juce::AudioFormatReader* sourceReader)
+    : juce::AudioFormatReader(nullptr, sourceReader->getFormatName()),
+      source(sourceReader)
+{
+    jassert(source->usesFloatingPointData);
+
+    sampleRate = source->sampleRate;
+    bitsPerSample = source->bitsPerSample;
+    lengthInSamples = source->lengthInSamples;
+    numChannels = source->numChannels;
+    usesFloatingPointData = source->usesFloatingPointData;
+    metadataValues = source->metadataValues;
+}
+
+HotCueBank* HotCueReader::swapBank(HotCueBank* newBank) noexcept
+{
+    auto* old = bank.release();
+    bank.reset(newBank);
+    return old;
+}
+
+bool HotCueReader::isResident(juce::int64 position) const noexcept
+{
+    return bank != nullptr && bank->findSnippet(position) != nullptr;
+}
+
+bool HotCueReader::readSamples(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+    juce::int64 startSampleInFile, int numSamples)
+{
+    const auto* snippet = bank != nullptr ? bank->findSnippet(startSampleInFile) : nullptr;
+    if (snippet == nullptr)
+        return source->readSamples(destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+
+    const int offset = (int)(startSampleInFile - snippet->start);
+    const int fromSnippet = juce::jmin(numSamples, snippet->audio.getNumSamples() - offset);
+
+    for (int ch = 0; ch < numDestChannels; ++ch)
+    {
+        if (destSamples[ch] == nullptr)
+            continue;
+
+        // the destinations hold floats, see usesFloatingPointData
+        auto* dest = reinterpret_cast<float*>(destSamples[ch]) + startOffsetInDestBuffer;
+        if (ch < snippet->audio.getNumChannels())
+            juce::FloatVectorOperations::copy(dest, snippet->audio.getReadPointer(ch, offset), fromSnippet);
+        else
+            juce::FloatVectorOperations::clear(dest, fromSnippet);
+    }
+
+    // an empty read only moves the read-ahead to the playhead
+    source->readSamples(destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, 0);
+
+    if (fromSnippet == numSamples)
+        return true;
+
+    return source->readSamples(destSamples, numDestChannels, startOffsetInDestBuffer + fromSnippet,
+        startSampleInFile + fromSnippet, numSamples - fromSnippet);
+}
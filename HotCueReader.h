@@ -0,0 +1,60 @@
+#pragma once
+#include <JuceHeader.h>
+
+// The hot cues of a track and, for each, the decoded audio that follows it.
+// Built on a background thread and never changed afterwards. Snippets are shared with the bank
+// that replaces this one, so moving or adding one cue doesn't decode the others again.
+struct HotCueBank
+{
+	struct Snippet
+	{
+		juce::int64 start = 0;
+		juce::AudioBuffer<float> audio;
+	};
+
+	using SnippetPtr = std::shared_ptr<const Snippet>;
+
+	// cue positions in samples, sorted
+	std::vector<juce::int64> cues;
+
+	// sorted by start
+	std::vector<SnippetPtr> snippets;
+
+	// the snippet holding this sample, or nullptr
+	const Snippet* findSnippet(juce::int64 position) const noexcept;
+
+	// Decodes numSamples from each cue, taking snippets that already exist from reusable.
+	// Returns nullptr if shouldExit returned true along the way.
+	static std::unique_ptr<HotCueBank> build(juce::AudioFormatReader& reader,
+		std::vector<juce::int64> cuePositions, int numSamples,
+		const std::vector<SnippetPtr>& reusable,
+		const std::function<bool()>& shouldExit);
+};
+
+// Sits between the reader source and a streaming reader and answers reads that fall inside a
+// hot cue snippet from memory, so a jump to a cue plays at once instead of waiting for the
+// read-ahead to refill. Meanwhile the read-ahead is pointed at the playhead, so the audio after
+// the snippet is decoded by the time it's needed.
+// The source must deliver floats, as ReadAheadReader does.
+class HotCueReader : public juce::AudioFormatReader
+{
+public:
+	// takes ownership of the source
+	explicit HotCueReader(juce::AudioFormatReader* sourceReader);
+
+	// Installs a bank (may be null) and returns the one it replaces, which the caller must free
+	// on the message thread. Call from the audio thread, or while nothing is rendering.
+	HotCueBank* swapBank(HotCueBank* newBank) noexcept;
+
+	// Whether a read starting here would come from memory
+	bool isResident(juce::int64 position) const noexcept;
+
+	bool readSamples(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+		juce::int64 startSampleInFile, int numSamples) override;
+
+private:
+	std::unique_ptr<juce::AudioFormatReader> source;
+	std::unique_ptr<HotCueBank> bank;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HotCueReader)
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Fixed-size queue for exactly one producer thread and one consumer thread.
+// Never locks or allocates after construction, so either end may be the audio thread.
+// Holds up to capacity - 1 items.
+template <typename Item, int capacity>
+class LockFreeQueue
+{
+public:
+	LockFreeQueue() = default;
+
+	// Producer: returns false if the queue is full
+	bool push(const Item& item) noexcept
+	{
+		if (fifo.getFreeSpace() == 0)
+			return false;
+
+		fifo.write(1).forEach([this, &item](int index) { items[(size_t)index] = item; });
+		return true;
+	}
+
+	// Consumer: returns false if the queue is empty
+	bool pop(Item& item) noexcept
+	{
+		if (fifo.getNumReady() == 0)
+			return false;
+
+		fifo.read(1).forEach([this, &item](int index) { item = items[(size_t)index]; });
+		return true;
+	}
+
+	bool isEmpty() const noexcept { return fifo.getNumReady() == 0; }
+
+private:
+	juce::AbstractFifo fifo{ capacity };
+	std::array<Item, (size_t)capacity> items{};
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LockFreeQueue)
+};
@@ -1,5 +1,9 @@
 #include <JuceHeader.h>
+#include "AllocationCounter.h"
+#include "AudioThreadTrap.h"
+#include "Benchmarks.h"
 #include "MainComponent.h"
+#include "OfflineRenderer.h"
 
 // Our application class
 class SimpleAudioPlayer : public juce::JUCEApplication
@@ -8,15 +12,49 @@ public:
     const juce::String getApplicationName() override { return "Simple Audio Player"; }
     const juce::String getApplicationVersion() override { return "1.0"; }
 
-    void initialise(const juce::String&) override
+    void initialise(const juce::String& commandLine) override
     {
+        juce::ArgumentList args(getApplicationName(), commandLine);
+
+        // "--benchmark <name>" times the audio code paths, prints the results and quits without a window
+        if (args.containsOption("--benchmark"))
+        {
+            const bool known = Benchmarks::run(args.getValueForOption("--benchmark"));
+            setApplicationReturnValue(known ? 0 : 1);
+            quit();
+            return;
+        }
+
+        // "--render out.wav file..." mixes the files without a device or window, then quits
+        if (args.containsOption("--render"))
+        {
+            setApplicationReturnValue(OfflineRenderer::runFromCommandLine(args));
+            quit();
+            return;
+        }
+
+        // "--trap-audio-thread" logs every allocation and lock in the audio callback with its stack
+        if (args.containsOption("--trap-audio-thread"))
+        {
+            AudioThreadTrap::setEnabled(true);
+
+            if (!AllocationCounter::isCounting && !AUDIO_THREAD_TRAP_HOOKS_LIBC)
+                juce::Logger::writeToLog("Audio thread trap: this build hooks neither operator new nor malloc");
+        }
+
+        // "--decks N" overrides the number of decks from the last session
+        const int numDecks = args.getValueForOption("--decks").getIntValue();
+
         // Create and show the main window
-        mainWindow = std::make_unique<MainWindow>(getApplicationName());
+        mainWindow = std::make_unique<MainWindow>(getApplicationName(), numDecks);
     }
 
     void shutdown() override
     {
         mainWindow = nullptr; // Clean up
+
+        if (AudioThreadTrap::isEnabled())
+            juce::Logger::writeToLog(juce::String(AudioThreadTrap::getViolationCount()) + " audio thread violations");
     }
 
 private:
@@ -24,13 +62,13 @@ private:
     class MainWindow : public juce::DocumentWindow
     {
     public:
-        MainWindow(juce::String name)
+        MainWindow(juce::String name, int numDecks)
             : DocumentWindow(name,
                 juce::Colours::lightgrey,
                 DocumentWindow::allButtons)
         {
             setUsingNativeTitleBar(true);
-            setContentOwned(new MainComponent(), true); // MainComponent = our UI + logic
+            setContentOwned(new MainComponent(numDecks), true); // MainComponent = our UI + logic
             centreWithSize(1600, 800);
             setVisible(true);
         }
@@ -1,42 +1,58 @@
 ﻿#include "MainComponent.h"
 
-MainComponent::MainComponent()
+MainComponent::MainComponent(int numDecksToUse)
 {
-    // Player 1
-    addAndMakeVisible(gui1);
-    gui1.setAudio(&audio1); 
+    juce::PropertiesFile::Options options;
+    options.applicationName = "Simple Audio Player";
+    options.filenameSuffix = ".xml"; 
+    options.folderName = "SimpleAudioPlayer";
+    options.osxLibrarySubFolder = "Application Support";
+
+    appProperties.setStorageParameters(options);
 
-    // Player 2
-    addAndMakeVisible(gui2);
-    gui2.setAudio(&audio2); 
+	// the deck count has to be known before the mixer is built
+    int numDecks = numDecksToUse;
+    if (numDecks <= 0)
+        if (auto* props = appProperties.getUserSettings())
+            numDecks = props->getIntValue("numDecks", 2);
 
-    setSize(500, 250);
-    setAudioChannels(0, 2);
+    mixer = std::make_unique<MixerEngine>(numDecks);
 
-	// Add audio1 sources to mixer
-    mixerSource.addInputSource(audio1.getAudioSource(), false);
+    addAndMakeVisible(deckViewport);
+    deckViewport.setViewedComponent(&deckArea, false);
+    deckViewport.setScrollBarsShown(true, false);
 
-	// Add audio2 sources to mixer
-    mixerSource.addInputSource(audio2.getAudioSource(), false);
+	// one player GUI per deck
+    for (int i = 0; i < mixer->getNumDecks(); ++i)
+    {
+        auto* gui = guis.add(new PlayerGUI());
+        deckArea.addAndMakeVisible(gui);
+        gui->setAudio(&mixer->getDeck(i));
+        gui->volumeSlider.addListener(this);
+    }
 
     // Mixer Button
-    addAndMakeVisible(MixerButton);
+    deckArea.addAndMakeVisible(MixerButton);
     MixerButton.setButtonText("Mixer");
     MixerButton.addListener(this);
 
-    gui1.volumeSlider.addListener(this);
-    gui2.volumeSlider.addListener(this);
+    deckArea.addAndMakeVisible(profilerButton);
+    profilerButton.setClickingTogglesState(true);
+    profilerButton.addListener(this);
 
-    
-    juce::PropertiesFile::Options options;
-    options.applicationName = "Simple Audio Player";
-    options.filenameSuffix = ".xml"; 
-    options.folderName = "SimpleAudioPlayer";
-    options.osxLibrarySubFolder = "Application Support";
+    profilerOverlay = std::make_unique<ProfilerOverlay>(mixer->getProfiler());
+    addChildComponent(*profilerOverlay);
 
-    appProperties.setStorageParameters(options);
+    setSize(500, 250);
+    setAudioChannels(0, 2);
+
+    // drop the waveforms of files that haven't been shown for a long time
+    decodeThreads->getJobPool().addJob([]()
+        {
+            WaveformPeaks::pruneCache();
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
 
-   
     loadState();
 
     updateMix();
@@ -47,37 +63,31 @@ MainComponent::~MainComponent()
 {
     saveState();
 
-    gui1.volumeSlider.removeListener(this);
-    gui2.volumeSlider.removeListener(this);
-
-    mixerSource.removeAllInputs();
+    for (auto* gui : guis)
+        gui->volumeSlider.removeListener(this);
 
     shutdownAudio();
 
     MixerButton.removeListener(this);
+    profilerButton.removeListener(this);
 }
 
 void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
-	// Prepare individual audio sources
-    audio1.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    audio2.prepareToPlay(samplesPerBlockExpected, sampleRate);
-
-	// Prepare mixer source
-    mixerSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+	// Prepare the mixer and every deck
+    mixer->prepareToPlay(samplesPerBlockExpected, sampleRate);
 }
 
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-	// Get mixed audio from mixer source
-    mixerSource.getNextAudioBlock(bufferToFill);
+	// Get mixed audio from the mixer; with the trap on, anything in here that allocates or locks is reported
+    const AudioThreadTrap::ScopedCallback callback;
+    mixer->getNextAudioBlock(bufferToFill);
 }
 
 void MainComponent::releaseResources()
 {
-    mixerSource.releaseResources();
-    audio1.releaseResources();
-    audio2.releaseResources();
+    mixer->releaseResources();
 }
 
 void MainComponent::paint(juce::Graphics& g)
@@ -94,142 +104,181 @@ void MainComponent::resized()
     const int buttonHeight = 40;      
     const int topBottomPadding = 10;  
 
-	// Take the bounds and reduce for padding
-    auto bounds = getLocalBounds().reduced(0, topBottomPadding);
+    deckViewport.setBounds(getLocalBounds());
+
+	// every row is as tall as the window; leave room for the scroll bar when rows don't fit
+    const int numRows = (guis.size() + 1) / 2;
+    const int scrollBarWidth = numRows > 1 ? deckViewport.getScrollBarThickness() : 0;
+    const int rowHeight = getHeight();
+    deckArea.setSize(getWidth() - scrollBarWidth, rowHeight * numRows);
+
+    for (int row = 0; row < numRows; ++row)
+    {
+	    // Take the row bounds and reduce for padding
+        auto bounds = juce::Rectangle<int>(0, row * rowHeight, deckArea.getWidth(), rowHeight).reduced(0, topBottomPadding);
+
+	    // calculate total content width
+        int totalContentWidth = (fixedPlayerWidth * 2) + buttonWidth;
 
-	// calculate total content width
-    int totalContentWidth = (fixedPlayerWidth * 2) + buttonWidth;
+	    // calculate starting x position to center content
+        int contentX = (bounds.getWidth() - totalContentWidth) / 2;
 
-	// calculate starting x position to center content
-    int contentX = (bounds.getWidth() - totalContentWidth) / 2;
+	    // Make a rectangle for the content area
+        juce::Rectangle<int> contentArea(contentX, bounds.getY(), totalContentWidth, bounds.getHeight());
 
-	// Make a rectangle for the content area
-    juce::Rectangle<int> contentArea(contentX, bounds.getY(), totalContentWidth, bounds.getHeight());
+	    // Place the left deck
+        guis[row * 2]->setBounds(contentArea.removeFromLeft(fixedPlayerWidth));
 
-	// Place Player 1 (lift)
-    gui1.setBounds(contentArea.removeFromLeft(fixedPlayerWidth));
+	    // Place Mixer Button (middle of the first row)
+        auto middle = contentArea.removeFromLeft(buttonWidth);
+        if (row == 0)
+        {
+            MixerButton.setBounds(middle.removeFromTop(buttonHeight));
+            profilerButton.setBounds(middle.removeFromBottom(buttonHeight));
+        }
 
-	// Place Mixer Button (middle)
-    MixerButton.setBounds(contentArea.removeFromLeft(buttonWidth).removeFromTop(buttonHeight));
+        // Place the right deck
+        if (auto* right = guis[row * 2 + 1])
+            right->setBounds(contentArea);
+    }
 
-    // Place Player 2 (right)
-    gui2.setBounds(contentArea);
+    // top right, over the decks
+    const int overlayWidth = juce::jmin(640, getWidth());
+    profilerOverlay->setBounds(getWidth() - overlayWidth, 0, overlayWidth,
+        juce::jmin(getHeight(), profilerOverlay->getIdealHeight()));
 }
 
 void MainComponent::sliderValueChanged(juce::Slider* slider)
 {
-    if (slider == &gui1.volumeSlider || slider == &gui2.volumeSlider)
+    for (auto* gui : guis)
     {
-        updateMix();
+        if (slider == &gui->volumeSlider)
+        {
+            updateMix();
+            return;
+        }
     }
 }
 
 
 void MainComponent::buttonClicked(juce::Button* button)
 {
-    if (button == &MixerButton)
+    if (button == &profilerButton)
     {
-        audio1.restart();
-        audio2.restart();
+        setProfiling(profilerButton.getToggleState());
+        return;
+    }
 
-        if (gui1.pauseButtonIcon.get()) 
+    if (button == &MixerButton)
+    {
+        for (int i = 0; i < guis.size(); ++i)
         {
-            gui1.ppButton.setImages(gui1.pauseButtonIcon.get());
-        }
+            mixer->getDeck(i).restart();
 
-        if (gui2.pauseButtonIcon.get()) 
-        {
-            gui2.ppButton.setImages(gui2.pauseButtonIcon.get());
+            auto* gui = guis[i];
+            if (gui->pauseButtonIcon.get()) 
+            {
+                gui->ppButton.setImages(gui->pauseButtonIcon.get());
+            }
         }
-       
     }
 }
 
-void MainComponent::updateMix()
+void MainComponent::setProfiling(bool shouldProfile)
 {
-    float vol1 = (float)gui1.volumeSlider.getValue();
-    float vol2 = (float)gui2.volumeSlider.getValue();
+    auto& profiler = mixer->getProfiler();
+
+    // start counting afresh each time, so old misses don't hide new ones
+    if (shouldProfile && !profiler.isEnabled())
+        profiler.reset();
 
+    profiler.setEnabled(shouldProfile);
+    profiler.setLogInterval(shouldProfile ? 10 : 0);
+
+    profilerButton.setToggleState(shouldProfile, juce::dontSendNotification);
+    profilerOverlay->setVisible(shouldProfile);
+    resized();
+}
+
+void MainComponent::updateMix()
+{
 	// set gains
-    audio1.setGain(vol1);
-    audio2.setGain(vol2);
+    for (int i = 0; i < guis.size(); ++i)
+        mixer->getDeck(i).setGain((float)guis[i]->volumeSlider.getValue());
 }
 
 
 
 void MainComponent::saveState()
 {
-	// Player 1
     juce::PropertiesFile* props = appProperties.getUserSettings();
     if (props == nullptr)
         return;
 
-	// get playlist files for Player 1
-    const auto& playlist1 = gui1.getPlaylistFileObjects();
-    juce::StringArray playlistPaths1;
+    props->setValue("numDecks", guis.size());
+    props->setValue("profiler", mixer->getProfiler().isEnabled());
+
+    for (int i = 0; i < guis.size(); ++i)
+        saveDeckState(*props, i);
+
+    appProperties.saveIfNeeded();
+
+	// keep parsed tags for the next start
+    metadataCache->save();
+}
+
+void MainComponent::saveDeckState(juce::PropertiesFile& props, int deckIndex)
+{
+    auto& gui = *guis[deckIndex];
+    auto& audio = mixer->getDeck(deckIndex);
+    const juce::String n(deckIndex + 1);
+
+	// get playlist files for this deck
+    const auto& playlist = gui.getPlaylistFileObjects();
+    juce::StringArray playlistPaths;
 
 	// store file paths in string array
-    for (const auto& file : playlist1)
-        playlistPaths1.add(file.getFullPathName());
+    for (const auto& file : playlist)
+        playlistPaths.add(file.getFullPathName());
 
 	// save playlist paths as a single string with newlines
-    props->setValue("playlist1", playlistPaths1.joinIntoString("\n")); 
+    props.setValue("playlist" + n, playlistPaths.joinIntoString("\n")); 
 
-	// get track durations for Player 1
-    const auto& durationsVector1 = gui1.playlistModel->trackDurations;
-    juce::StringArray durationsArray1;
-    for (const auto& dur : durationsVector1)
-        durationsArray1.add(dur);
-    props->setValue("playlistDurations1", durationsArray1.joinIntoString("\n"));
+	// get track durations
+    const auto& durationsVector = gui.playlistModel->trackDurations;
+    juce::StringArray durationsArray;
+    for (const auto& dur : durationsVector)
+        durationsArray.add(dur);
+    props.setValue("playlistDurations" + n, durationsArray.joinIntoString("\n"));
 
-    juce::File currentFile1 = audio1.getCurrentFile();
-    if (currentFile1.existsAsFile())
+    juce::File currentFile = audio.getCurrentFile();
+    if (currentFile.existsAsFile())
     {
-        props->setValue("lastFile1", currentFile1.getFullPathName());
-        props->setValue("lastPosition1", audio1.getCurrentPosition());
+        props.setValue("lastFile" + n, currentFile.getFullPathName());
+        props.setValue("lastPositionSamples" + n, audio.getPosition());
+        props.removeValue("lastPosition" + n);
     }
     else
     {
-        props->removeValue("lastFile1");
-        props->removeValue("lastPosition1");
+        props.removeValue("lastFile" + n);
+        props.removeValue("lastPositionSamples" + n);
+        props.removeValue("lastPosition" + n);
     }
 
-    props->setValue("volume1", gui1.volumeSlider.getValue());
-    props->setValue("speed1", audio1.getSpeed());
-    props->setValue("repeat1", audio1.isLooping());
-
-    // Player 2
-    const auto& playlist2 = gui2.getPlaylistFileObjects();
-    juce::StringArray playlistPaths2;
-    for (const auto& file : playlist2)
-        playlistPaths2.add(file.getFullPathName());
-    props->setValue("playlist2", playlistPaths2.joinIntoString("\n")); 
-
-    const auto& durationsVector2 = gui2.playlistModel->trackDurations;
-    juce::StringArray durationsArray2;
-    for (const auto& dur : durationsVector2)
-        durationsArray2.add(dur);
-    props->setValue("playlistDurations2", durationsArray2.joinIntoString("\n")); 
-
-    juce::File currentFile2 = audio2.getCurrentFile();
-    if (currentFile2.existsAsFile())
-    {
-        props->setValue("lastFile2", currentFile2.getFullPathName());
-        props->setValue("lastPosition2", audio2.getCurrentPosition());
-    }
-    else
-    {
-        props->removeValue("lastFile2");
-        props->removeValue("lastPosition2");
-    }
-
-    props->setValue("volume2", gui2.volumeSlider.getValue());
-    props->setValue("speed2", audio2.getSpeed());
-    props->setValue("repeat2", audio2.isLooping());
-
-   
-
-    appProperties.saveIfNeeded();
+    props.setValue("volume" + n, gui.volumeSlider.getValue());
+    props.setValue("pan" + n, audio.getPan());
+    props.setValue("speed" + n, audio.getSpeed());
+    props.setValue("keepPitch" + n, audio.getKeepPitch());
+    props.setValue("stretchQuality" + n, (int)audio.getStretchQuality());
+    props.setValue("resampler" + n, (int)audio.getResampler());
+    props.setValue("ramPreload" + n, audio.isRamPreloadEnabled());
+    props.setValue("ramPreloadFormat" + n, (int)audio.getRamPreloadFormat());
+
+    const auto& crossfade = audio.getPlaylistCrossfade();
+    props.setValue("crossfadeSeconds" + n, crossfade.seconds);
+    props.setValue("crossfadeCurve" + n, (int)crossfade.curve);
+    props.setValue("crossfadeSkipSilence" + n, crossfade.detectSilence);
+    props.setValue("repeat" + n, audio.isLooping());
 }
 
 
@@ -239,94 +288,96 @@ void MainComponent::loadState()
     if (props == nullptr)
         return;
 
-	// Load Player 1 state
-    float volume1 = (float)props->getDoubleValue("volume1", 0.5);
-    gui1.volumeSlider.setValue(volume1, juce::dontSendNotification);
+    for (int i = 0; i < guis.size(); ++i)
+        loadDeckState(*props, i);
+
+    setProfiling(props->getBoolValue("profiler", false));
+
+    
+    updateMix();
+}
+
+void MainComponent::loadDeckState(juce::PropertiesFile& props, int deckIndex)
+{
+    auto& gui = *guis[deckIndex];
+    auto& audio = mixer->getDeck(deckIndex);
+    const juce::String n(deckIndex + 1);
+
+	// Load volume
+    float volume = (float)props.getDoubleValue("volume" + n, 0.5);
+    gui.volumeSlider.setValue(volume, juce::dontSendNotification);
+
+	// load balance
+    audio.setPan((float)props.getDoubleValue("pan" + n, 0.0));
+    gui.panSlider.setValue(audio.getPan(), juce::dontSendNotification);
 
 	// load speed and repeat
-    double speed1 = props->getDoubleValue("speed1", 1.0);
-    audio1.setSpeed(speed1);
-    bool repeat1 = props->getBoolValue("repeat1", false);
-    audio1.setLooping(repeat1);
+    double speed = props.getDoubleValue("speed" + n, 1.0);
+    audio.setSpeed(speed);
+    audio.setKeepPitch(props.getBoolValue("keepPitch" + n, false));
+    audio.setStretchQuality((TimeStretchSource::Quality)juce::jlimit(0, 2,
+        props.getIntValue("stretchQuality" + n, (int)TimeStretchSource::Quality::balanced)));
+    audio.setResampler(props.getIntValue("resampler" + n, 0) == (int)PlayerAudio::Resampler::sinc
+        ? PlayerAudio::Resampler::sinc : PlayerAudio::Resampler::standard);
+    bool repeat = props.getBoolValue("repeat" + n, false);
+    audio.setLooping(repeat);
+    audio.setRamPreload(props.getBoolValue("ramPreload" + n, false));
+    audio.setRamPreloadFormat(props.getIntValue("ramPreloadFormat" + n, 0) == (int)PreloadedAudio::SampleFormat::int16
+        ? PreloadedAudio::SampleFormat::int16 : PreloadedAudio::SampleFormat::float32);
+
+    PlaylistCrossfade crossfade;
+    crossfade.seconds = props.getDoubleValue("crossfadeSeconds" + n, 0.0);
+    crossfade.curve = (PlaylistCrossfade::Curve)juce::jlimit(0, 2, props.getIntValue("crossfadeCurve" + n, 0));
+    crossfade.detectSilence = props.getBoolValue("crossfadeSkipSilence" + n, false);
+    audio.setPlaylistCrossfade(crossfade);
+    gui.updateControlsFromAudio();
 
 	// load playlist
-    juce::StringArray playlistPaths1;
-    playlistPaths1.addLines(props->getValue("playlist1", ""));
+    juce::StringArray playlistPaths;
+    playlistPaths.addLines(props.getValue("playlist" + n, ""));
 
 	// load durations
-    juce::StringArray playlistDurations1;
-    playlistDurations1.addLines(props->getValue("playlistDurations1", ""));
+    juce::StringArray playlistDurations;
+    playlistDurations.addLines(props.getValue("playlistDurations" + n, ""));
 
 	// convert paths to File objects
-    std::vector<juce::File> playlistFiles1;
-    for (const auto& path : playlistPaths1)
-        if (path.isNotEmpty()) playlistFiles1.push_back(juce::File(path));
+    std::vector<juce::File> playlistFiles;
+    for (const auto& path : playlistPaths)
+        if (path.isNotEmpty()) playlistFiles.push_back(juce::File(path));
 
 	// set playlist in GUI
-    gui1.setPlaylist(playlistFiles1, playlistDurations1); 
+    gui.setPlaylist(playlistFiles, playlistDurations); 
 
 	// load last file and position if available
-    juce::String lastFilePath1 = props->getValue("lastFile1", "");
-    if (lastFilePath1.isNotEmpty())
-    {
-        juce::File lastFile1(lastFilePath1);
-        if (lastFile1.existsAsFile())
-        {
-            audio1.loadFileDirect(lastFile1);
-            double lastPosition1 = props->getDoubleValue("lastPosition1", 0.0);
-            audio1.setPosition(lastPosition1);
-            if (audio1.onFileLoaded) audio1.onFileLoaded();
-            double total1 = audio1.getTotalLengthSeconds();
-            if (total1 > 0.0)
-            {
-                gui1.progressSlider.setValue(lastPosition1 / total1, juce::dontSendNotification);
-                gui1.currentTimeLabel.setText(gui1.formatTime(lastPosition1), juce::dontSendNotification);
-                gui1.totalTimeLabel.setText(gui1.formatTime(total1), juce::dontSendNotification);
-            }
-            gui1.ppButton.setImages(gui1.playIcon.get());
-        }
-    }
-
-
-    float volume2 = (float)props->getDoubleValue("volume2", 0.5);
-    gui2.volumeSlider.setValue(volume2, juce::dontSendNotification);
-    double speed2 = props->getDoubleValue("speed2", 1.0);
-    audio2.setSpeed(speed2);
-    bool repeat2 = props->getBoolValue("repeat2", false);
-    audio2.setLooping(repeat2);
-
-    juce::StringArray playlistPaths2;
-    playlistPaths2.addLines(props->getValue("playlist2", ""));
-    juce::StringArray playlistDurations2;
-    playlistDurations2.addLines(props->getValue("playlistDurations2", ""));
-    std::vector<juce::File> playlistFiles2;
-    for (const auto& path : playlistPaths2)
-        if (path.isNotEmpty()) playlistFiles2.push_back(juce::File(path));
-    gui2.setPlaylist(playlistFiles2, playlistDurations2); 
-
-    juce::String lastFilePath2 = props->getValue("lastFile2", "");
-    if (lastFilePath2.isNotEmpty())
+    juce::String lastFilePath = props.getValue("lastFile" + n, "");
+    if (lastFilePath.isNotEmpty())
     {
-        juce::File lastFile2(lastFilePath2);
-        if (lastFile2.existsAsFile())
+        juce::File lastFile(lastFilePath);
+        if (lastFile.existsAsFile())
         {
-            audio2.loadFileDirect(lastFile2);
-            double lastPosition2 = props->getDoubleValue("lastPosition2", 0.0);
-            audio2.setPosition(lastPosition2);
-            if (audio2.onFileLoaded) audio2.onFileLoaded();
-            double total2 = audio2.getTotalLengthSeconds();
-            if (total2 > 0.0)
-            {
-                gui2.progressSlider.setValue(lastPosition2 / total2, juce::dontSendNotification);
-                gui2.currentTimeLabel.setText(gui2.formatTime(lastPosition2), juce::dontSendNotification);
-                gui2.totalTimeLabel.setText(gui2.formatTime(total2), juce::dontSendNotification);
-            }
-            gui2.ppButton.setImages(gui2.playIcon.get());
+            // settings from older versions kept the position in seconds, which needs the file's rate
+            const bool hasSamplePosition = props.containsKey("lastPositionSamples" + n);
+            const juce::int64 samplePosition = props.getValue("lastPositionSamples" + n).getLargeIntValue();
+            const double secondsPosition = props.getDoubleValue("lastPosition" + n, 0.0);
+
+            // the decks and their GUIs outlive any load still opening, see ~PlayerAudio
+            audio.loadFileInBackground(lastFile, [&audio, &gui, hasSamplePosition, samplePosition, secondsPosition](bool loaded)
+                {
+                    if (!loaded)
+                        return;
+
+                    const juce::int64 lastPosition = hasSamplePosition ? samplePosition : audio.secondsToSamples(secondsPosition);
+                    audio.setPosition(lastPosition);
+                    if (audio.onFileLoaded) audio.onFileLoaded();
+                    const juce::int64 length = audio.getTotalLength();
+                    if (length > 0)
+                    {
+                        gui.progressSlider.setValue((double)lastPosition / (double)length, juce::dontSendNotification);
+                        gui.currentTimeLabel.setText(gui.formatPosition(lastPosition), juce::dontSendNotification);
+                        gui.totalTimeLabel.setText(gui.formatPosition(length), juce::dontSendNotification);
+                    }
+                });
+            gui.ppButton.setImages(gui.playIcon.get());
         }
     }
-
-    
-    updateMix();
-}
-
-
+}
\ No newline at end of file
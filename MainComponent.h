@@ -1,15 +1,19 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "AudioThreadTrap.h"
 #include "PlayerGUI.h"
 #include "PlayerAudio.h"
+#include "MixerEngine.h"
+#include "ProfilerOverlay.h"
 
 class MainComponent : public juce::AudioAppComponent,
 	public juce::Slider::Listener,
 	public juce::Button::Listener
 {
 public:
-	MainComponent();
+	// numDecksToUse <= 0 uses the number of decks from the last session (two on first start)
+	explicit MainComponent(int numDecksToUse = 0);
 	~MainComponent() override;
 
 
@@ -26,27 +30,34 @@ public:
 	void buttonClicked(juce::Button* button) override;
 	
 private:
-	// Player 1
-	PlayerGUI gui1;
-	PlayerAudio audio1;
+	// One PlayerGUI per deck of the mixer, in the same order
+	std::unique_ptr<MixerEngine> mixer;
+	juce::OwnedArray<PlayerGUI> guis;
 
-	// Player 2
-	PlayerGUI gui2;
-	PlayerAudio audio2;
-
-	// Mixer 
-	juce::MixerAudioSource mixerSource;
+	// Decks are laid out two per row; more rows scroll
+	juce::Component deckArea;
+	juce::Viewport deckViewport;
 
 	// Mixer Button
 	juce::TextButton MixerButton;
 
+	// Profiler button: times the audio callback, shows the overlay and logs the report
+	juce::TextButton profilerButton{ "Profiler" };
+	std::unique_ptr<ProfilerOverlay> profilerOverlay;
+	void setProfiling(bool shouldProfile);
+
 	void saveState();
 	void loadState();
 
+	// settings keys end in the deck number, counting from 1 ("volume1", "volume2", ...)
+	void saveDeckState(juce::PropertiesFile& props, int deckIndex);
+	void loadDeckState(juce::PropertiesFile& props, int deckIndex);
+
 	void updateMix();
 
 	juce::ApplicationProperties appProperties;
+	juce::SharedResourcePointer<MetadataCache> metadataCache;
+	juce::SharedResourcePointer<DecodeThreadPool> decodeThreads;
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
 };
-
@@ -0,0 +1,71 @@
+#include "MappedPcmReader.h"
+
+std::unique_ptr<MappedPcmReader> MappedPcmReader::create(juce::AudioFormat& format, const juce::File& file,
+    juce::TimeSliceThread& thread, double secondsToTouchAhead)
+{
+    // formats without a mapped reader (MP3, FLAC, ...) return nullptr here
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader(format.createMemoryMappedReader(file));
+    if (mappedReader == nullptr || mappedReader->lengthInSamples <= 0 || !mappedReader->mapEntireFile())
+        return nullptr;
+
+    return std::unique_ptr<MappedPcmReader>(new MappedPcmReader(std::move(mappedReader), thread, secondsToTouchAhead));
+}
+
+MappedPcmReader::MappedPcmReader(std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader,
+    juce::TimeSliceThread& thread, double secondsToTouchAhead)
+    : juce::AudioFormatReader(nullptr, mappedReader->getFormatName()),
+      mapped(std::move(mappedReader)),
+      pagingThread(thread),
+      touchAhead(juce::jmax(1, (int)(secondsToTouchAhead * mapped->sampleRate)))
+{
+    sampleRate = mapped->sampleRate;
+    bitsPerSample = mapped->bitsPerSample;
+    lengthInSamples = mapped->lengthInSamples;
+    numChannels = mapped->numChannels;
+    usesFloatingPointData = mapped->usesFloatingPointData;
+    metadataValues = mapped->metadataValues;
+
+    const int bytesPerFrame = juce::jmax(1, (int)(bitsPerSample / 8 * numChannels));
+    samplesPerPage = juce::jmax(1, 4096 / bytesPerFrame);
+
+    // the start is what plays first, so have it resident before the track is handed over
+    touchRange(0, juce::jmin(lengthInSamples, (juce::int64)touchAhead));
+    touchedUpTo = juce::jmin(lengthInSamples, (juce::int64)touchAhead);
+
+    pagingThread.addTimeSliceClient(this);
+}
+
+MappedPcmReader::~MappedPcmReader()
+{
+    pagingThread.removeTimeSliceClient(this);
+}
+
+bool MappedPcmReader::readSamples(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+    juce::int64 startSampleInFile, int numSamples)
+{
+    lastReadEnd.store(startSampleInFile + numSamples, std::memory_order_relaxed);
+    return mapped->readSamples(destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+}
+
+int MappedPcmReader::useTimeSlice()
+{
+    const auto position = juce::jlimit((juce::int64)0, lengthInSamples, lastReadEnd.load(std::memory_order_relaxed));
+
+    // after a jump start again from the new position
+    if (touchedUpTo < position || touchedUpTo > position + touchAhead)
+        touchedUpTo = position;
+
+    const auto end = juce::jmin(lengthInSamples, position + touchAhead);
+    if (touchedUpTo >= end)
+        return 50;
+
+    touchRange(touchedUpTo, end);
+    touchedUpTo = end;
+    return 5;
+}
+
+void MappedPcmReader::touchRange(juce::int64 start, juce::int64 end) noexcept
+{
+    for (auto sample = start; sample < end; sample += samplesPerPage)
+        mapped->touchSample(sample);
+}
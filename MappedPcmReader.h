@@ -0,0 +1,38 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Reader for uncompressed WAV and AIFF files that plays straight out of a memory-mapped file.
+// Reads are a copy and sample format conversion from the mapping, with no system calls, so seeks,
+// loop wraps and jumps cost no more than sequential playback. A read-ahead thread touches the
+// pages just ahead of the last read so the audio thread rarely takes a page fault.
+class MappedPcmReader : public juce::AudioFormatReader,
+                        private juce::TimeSliceClient
+{
+public:
+	// Returns nullptr if the format can't map this file (compressed, not PCM) or mapping fails
+	static std::unique_ptr<MappedPcmReader> create(juce::AudioFormat& format, const juce::File& file,
+		juce::TimeSliceThread& thread, double secondsToTouchAhead);
+
+	~MappedPcmReader() override;
+
+	bool readSamples(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+		juce::int64 startSampleInFile, int numSamples) override;
+
+private:
+	MappedPcmReader(std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader,
+		juce::TimeSliceThread& thread, double secondsToTouchAhead);
+
+	// touches the pages from the last read up to touchAhead samples beyond it
+	int useTimeSlice() override;
+	void touchRange(juce::int64 start, juce::int64 end) noexcept;
+
+	std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped;
+	juce::TimeSliceThread& pagingThread;
+	const int touchAhead;
+	int samplesPerPage = 1;
+
+	std::atomic<juce::int64> lastReadEnd{ 0 };
+	juce::int64 touchedUpTo = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MappedPcmReader)
+};
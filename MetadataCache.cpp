@@ -0,0 +1,254 @@
+#include "MetadataCache.h"
+#include <taglib/fileref.h>
+#include <taglib/tag.h>
+
+namespace
+{
+    const int cacheMagic = 0x4d504153; // "SAPM"
+    const int cacheVersion = 2; // 2 added the last use time
+}
+
+MetadataCache::MetadataCache()
+{
+    formatManager.registerBasicFormats();
+
+    cacheFile = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("SimpleAudioPlayer")
+        .getChildFile("MetadataCache.bin");
+
+    load();
+}
+
+MetadataCache::~MetadataCache()
+{
+    save();
+}
+
+TrackInfo::Ptr MetadataCache::get(const juce::File& file)
+{
+    const juce::String path = file.getFullPathName();
+    std::shared_ptr<juce::WaitableEvent> otherThreadChecking;
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        auto it = entries.find(path);
+        if (it != entries.end() && it->second.checkedThisSession)
+        {
+            it->second.lastUsed = juce::Time::currentTimeMillis();
+            dirty = true;
+            return it->second.info;
+        }
+
+        auto pending = inProgress.find(path);
+        if (pending != inProgress.end())
+            otherThreadChecking = pending->second;
+        else
+            inProgress[path] = std::make_shared<juce::WaitableEvent>(true);
+    }
+
+    if (otherThreadChecking != nullptr)
+    {
+        otherThreadChecking->wait();
+
+        const juce::ScopedLock sl(lock);
+        auto it = entries.find(path);
+        if (it != entries.end() && it->second.checkedThisSession)
+            return it->second.info;
+
+        // the file was missing for the other thread too
+        return new TrackInfo(file, {}, {}, {}, 0.0, 0.0, 0);
+    }
+
+    auto info = check(file);
+
+    const juce::ScopedLock sl(lock);
+    inProgress[path]->signal();
+    inProgress.erase(path);
+    return info;
+}
+
+TrackInfo::Ptr MetadataCache::check(const juce::File& file)
+{
+    // a missing file has no size, so it never matches an entry; don't remember it in case it comes back
+    const juce::int64 fileSize = file.getSize();
+    if (fileSize <= 0)
+        return new TrackInfo(file, {}, {}, {}, 0.0, 0.0, 0);
+
+    const juce::int64 modificationTime = file.getLastModificationTime().toMilliseconds();
+    const juce::String path = file.getFullPathName();
+
+    {
+        const juce::ScopedLock sl(lock);
+        auto it = entries.find(path);
+        if (it != entries.end()
+            && it->second.fileSize == fileSize
+            && it->second.modificationTime == modificationTime)
+        {
+            it->second.checkedThisSession = true;
+            it->second.lastUsed = juce::Time::currentTimeMillis();
+            dirty = true;
+            return it->second.info;
+        }
+    }
+
+    // parse without holding the lock so other files can be looked up meanwhile
+    Entry entry;
+    entry.fileSize = fileSize;
+    entry.modificationTime = modificationTime;
+    entry.info = parse(file);
+    entry.checkedThisSession = true;
+    entry.lastUsed = juce::Time::currentTimeMillis();
+
+    const juce::ScopedLock sl(lock);
+    entries[path] = entry;
+    dirty = true;
+    trimToLimit();
+    return entry.info;
+}
+
+TrackInfo::Ptr MetadataCache::parse(const juce::File& file)
+{
+    juce::String title, artist, album;
+
+    TagLib::FileRef ref(file.getFullPathName().toRawUTF8());
+    if (!ref.isNull() && ref.tag())
+    {
+        auto* tag = ref.tag();
+        title = juce::String::fromUTF8(tag->title().toCString(true)).trim();
+        artist = juce::String::fromUTF8(tag->artist().toCString(true)).trim();
+        album = juce::String::fromUTF8(tag->album().toCString(true)).trim();
+    }
+
+    // stream properties come from the reader that will play the file, so they always agree with it
+    double durationSeconds = 0.0;
+    double sampleRate = 0.0;
+    int numChannels = 0;
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader != nullptr && reader->sampleRate > 0.0)
+    {
+        sampleRate = reader->sampleRate;
+        numChannels = (int)reader->numChannels;
+        durationSeconds = (double)reader->lengthInSamples / reader->sampleRate;
+    }
+
+    return new TrackInfo(file, title, artist, album, durationSeconds, sampleRate, numChannels);
+}
+
+void MetadataCache::load()
+{
+    juce::FileInputStream in(cacheFile);
+    if (!in.openedOk())
+        return;
+
+    if (in.readInt() != cacheMagic)
+        return;
+
+    const int version = in.readInt();
+    if (version < 1 || version > cacheVersion)
+        return;
+
+    const int numEntries = in.readInt();
+
+    const juce::ScopedLock sl(lock);
+    for (int i = 0; i < numEntries && !in.isExhausted(); ++i)
+    {
+        const juce::String path = in.readString();
+
+        Entry entry;
+        entry.fileSize = in.readInt64();
+        entry.modificationTime = in.readInt64();
+
+        const juce::String title = in.readString();
+        const juce::String artist = in.readString();
+        const juce::String album = in.readString();
+        const double durationSeconds = in.readDouble();
+        const double sampleRate = in.readDouble();
+        const int numChannels = in.readInt();
+
+        // entries from before version 2 count as the least recently used
+        if (version >= 2)
+            entry.lastUsed = in.readInt64();
+
+        entry.info = new TrackInfo(juce::File(path), title, artist, album, durationSeconds, sampleRate, numChannels);
+        entries[path] = entry;
+    }
+
+    trimToLimit();
+}
+
+void MetadataCache::trimToLimit()
+{
+    if (entries.size() <= maxEntries)
+        return;
+
+    // down to 90% in one go, so adding many new files doesn't search the whole map for each one
+    const size_t numToDrop = entries.size() - maxEntries * 9 / 10;
+
+    std::vector<juce::int64> useTimes;
+    useTimes.reserve(entries.size());
+    for (const auto& [path, entry] : entries)
+        useTimes.push_back(entry.lastUsed);
+
+    std::nth_element(useTimes.begin(), useTimes.begin() + (std::ptrdiff_t)(numToDrop - 1), useTimes.end());
+    const auto newestDropped = useTimes[numToDrop - 1];
+
+    size_t numDropped = 0;
+    for (auto it = entries.begin(); it != entries.end() && numDropped < numToDrop;)
+    {
+        if (it->second.lastUsed <= newestDropped)
+        {
+            it = entries.erase(it);
+            ++numDropped;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    dirty = true;
+}
+
+void MetadataCache::save()
+{
+    const juce::ScopedLock sl(lock);
+    if (!dirty)
+        return;
+
+    cacheFile.getParentDirectory().createDirectory();
+
+    // write next to the real file and swap it in, so a crash never leaves a half-written cache
+    juce::TemporaryFile temp(cacheFile);
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+            return;
+
+        out.writeInt(cacheMagic);
+        out.writeInt(cacheVersion);
+        out.writeInt((int)entries.size());
+
+        for (const auto& [path, entry] : entries)
+        {
+            out.writeString(path);
+            out.writeInt64(entry.fileSize);
+            out.writeInt64(entry.modificationTime);
+            out.writeString(entry.info->title);
+            out.writeString(entry.info->artist);
+            out.writeString(entry.info->album);
+            out.writeDouble(entry.info->durationSeconds);
+            out.writeDouble(entry.info->sampleRate);
+            out.writeInt(entry.info->numChannels);
+            out.writeInt64(entry.lastUsed);
+        }
+
+        out.flush();
+        if (out.getStatus().failed())
+            return;
+    }
+
+    if (temp.overwriteTargetFileWithTemporary())
+        dirty = false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <JuceHeader.h>
+#include "TrackInfo.h"
+
+// The one place that reads tags and stream properties.
+// Each file is looked at no more than once per session: the first request checks the on-disk
+// cache (an entry is only used while the file's size and modification time still match) and parses
+// the file if needed, later requests get the same TrackInfo without touching the disk.
+// If several threads ask for the same file at once, one parses it and the others wait for that result.
+// At most maxEntries files are remembered; past that the least recently used are forgotten.
+// Shared through juce::SharedResourcePointer and safe to call from any thread.
+class MetadataCache
+{
+public:
+	MetadataCache();
+	~MetadataCache();
+
+	// Never null; the record is invalid if the file is missing or isn't audio
+	TrackInfo::Ptr get(const juce::File& file);
+
+	// Writes the cache to disk if anything changed since it was loaded
+	void save();
+
+	static constexpr size_t maxEntries = 20000;
+
+private:
+	struct Entry
+	{
+		juce::int64 fileSize = 0;
+		juce::int64 modificationTime = 0;
+		TrackInfo::Ptr info;
+
+		// set once the size and time have been compared with the file in this session
+		bool checkedThisSession = false;
+
+		// milliseconds since 1970 when the file was last asked for
+		juce::int64 lastUsed = 0;
+	};
+
+	// looks the file up on disk and in the stored entries, parsing it if needed
+	TrackInfo::Ptr check(const juce::File& file);
+	TrackInfo::Ptr parse(const juce::File& file);
+	void load();
+
+	// forgets the least recently used entries while there are more than maxEntries; call with lock held
+	void trimToLimit();
+
+	juce::File cacheFile;
+	juce::AudioFormatManager formatManager;
+
+	juce::CriticalSection lock;
+	std::unordered_map<juce::String, Entry> entries;
+	std::unordered_map<juce::String, std::shared_ptr<juce::WaitableEvent>> inProgress;
+	bool dirty = false;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MetadataCache)
+};
@@ -0,0 +1,165 @@
+#include "MixKernels.h"
+#include "SimdConfig.h"
+
+namespace
+{
+    // Adds one channel, stepping the gain per sample; returns how many samples it handled.
+    // The SIMD versions stop at the last whole vector and leave the rest to the scalar loop.
+    int addRampedVector(float* dest, const float* src, int numSamples, float startGain, float step) noexcept
+    {
+       #if SIMD_KERNELS_AVX
+        const int numVectors = numSamples / 8;
+        __m256 gain = _mm256_add_ps(_mm256_set1_ps(startGain),
+            _mm256_mul_ps(_mm256_set1_ps(step), _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)));
+        const __m256 gainStep = _mm256_set1_ps(step * 8.0f);
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            const __m256 d = _mm256_loadu_ps(dest + v * 8);
+            const __m256 s = _mm256_loadu_ps(src + v * 8);
+            _mm256_storeu_ps(dest + v * 8, _mm256_add_ps(d, _mm256_mul_ps(s, gain)));
+            gain = _mm256_add_ps(gain, gainStep);
+        }
+        return numVectors * 8;
+       #elif SIMD_KERNELS_SSE2
+        const int numVectors = numSamples / 4;
+        __m128 gain = _mm_add_ps(_mm_set1_ps(startGain),
+            _mm_mul_ps(_mm_set1_ps(step), _mm_setr_ps(0, 1, 2, 3)));
+        const __m128 gainStep = _mm_set1_ps(step * 4.0f);
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            const __m128 d = _mm_loadu_ps(dest + v * 4);
+            const __m128 s = _mm_loadu_ps(src + v * 4);
+            _mm_storeu_ps(dest + v * 4, _mm_add_ps(d, _mm_mul_ps(s, gain)));
+            gain = _mm_add_ps(gain, gainStep);
+        }
+        return numVectors * 4;
+       #elif SIMD_KERNELS_NEON
+        const int numVectors = numSamples / 4;
+        const float offsets[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        float32x4_t gain = vmlaq_n_f32(vdupq_n_f32(startGain), vld1q_f32(offsets), step);
+        const float32x4_t gainStep = vdupq_n_f32(step * 4.0f);
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            vst1q_f32(dest + v * 4, vmlaq_f32(vld1q_f32(dest + v * 4), vld1q_f32(src + v * 4), gain));
+            gain = vaddq_f32(gain, gainStep);
+        }
+        return numVectors * 4;
+       #else
+        juce::ignoreUnused(dest, src, numSamples, startGain, step);
+        return 0;
+       #endif
+    }
+
+    void addRampedScalar(float* dest, const float* src, int from, int numSamples, float startGain, float step) noexcept
+    {
+        for (int i = from; i < numSamples; ++i)
+            dest[i] += src[i] * (startGain + step * (float)i);
+    }
+}
+
+namespace MixKernels
+{
+    void addRamped(float* dest, const float* src, int numSamples, float startGain, float endGain) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        const float step = (endGain - startGain) / (float)numSamples;
+
+        // a fixed gain is a plain multiply-add, which JUCE already vectorises
+        if (step == 0.0f)
+        {
+            if (startGain != 0.0f)
+                juce::FloatVectorOperations::addWithMultiply(dest, src, startGain, numSamples);
+            return;
+        }
+
+        const int done = addRampedVector(dest, src, numSamples, startGain, step);
+        addRampedScalar(dest, src, done, numSamples, startGain, step);
+    }
+
+    void addRampedStereo(float* destLeft, float* destRight,
+        const float* srcLeft, const float* srcRight, int numSamples,
+        float startLeft, float endLeft, float startRight, float endRight) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        if (startLeft == endLeft && startRight == endRight)
+        {
+            addRamped(destLeft, srcLeft, numSamples, startLeft, endLeft);
+            addRamped(destRight, srcRight, numSamples, startRight, endRight);
+            return;
+        }
+
+        const float stepLeft = (endLeft - startLeft) / (float)numSamples;
+        const float stepRight = (endRight - startRight) / (float)numSamples;
+
+       #if SIMD_KERNELS_AVX
+        const int numVectors = numSamples / 8;
+        const __m256 offsets = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256 gainLeft = _mm256_add_ps(_mm256_set1_ps(startLeft), _mm256_mul_ps(_mm256_set1_ps(stepLeft), offsets));
+        __m256 gainRight = _mm256_add_ps(_mm256_set1_ps(startRight), _mm256_mul_ps(_mm256_set1_ps(stepRight), offsets));
+        const __m256 gainStepLeft = _mm256_set1_ps(stepLeft * 8.0f);
+        const __m256 gainStepRight = _mm256_set1_ps(stepRight * 8.0f);
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            const int i = v * 8;
+            _mm256_storeu_ps(destLeft + i, _mm256_add_ps(_mm256_loadu_ps(destLeft + i), _mm256_mul_ps(_mm256_loadu_ps(srcLeft + i), gainLeft)));
+            _mm256_storeu_ps(destRight + i, _mm256_add_ps(_mm256_loadu_ps(destRight + i), _mm256_mul_ps(_mm256_loadu_ps(srcRight + i), gainRight)));
+            gainLeft = _mm256_add_ps(gainLeft, gainStepLeft);
+            gainRight = _mm256_add_ps(gainRight, gainStepRight);
+        }
+        const int done = numVectors * 8;
+       #elif SIMD_KERNELS_SSE2
+        const int numVectors = numSamples / 4;
+        const __m128 offsets = _mm_setr_ps(0, 1, 2, 3);
+        __m128 gainLeft = _mm_add_ps(_mm_set1_ps(startLeft), _mm_mul_ps(_mm_set1_ps(stepLeft), offsets));
+        __m128 gainRight = _mm_add_ps(_mm_set1_ps(startRight), _mm_mul_ps(_mm_set1_ps(stepRight), offsets));
+        const __m128 gainStepLeft = _mm_set1_ps(stepLeft * 4.0f);
+        const __m128 gainStepRight = _mm_set1_ps(stepRight * 4.0f);
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            const int i = v * 4;
+            _mm_storeu_ps(destLeft + i, _mm_add_ps(_mm_loadu_ps(destLeft + i), _mm_mul_ps(_mm_loadu_ps(srcLeft + i), gainLeft)));
+            _mm_storeu_ps(destRight + i, _mm_add_ps(_mm_loadu_ps(destRight + i), _mm_mul_ps(_mm_loadu_ps(srcRight + i), gainRight)));
+            gainLeft = _mm_add_ps(gainLeft, gainStepLeft);
+            gainRight = _mm_add_ps(gainRight, gainStepRight);
+        }
+        const int done = numVectors * 4;
+       #elif SIMD_KERNELS_NEON
+        const int numVectors = numSamples / 4;
+        const float offsetValues[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        const float32x4_t offsets = vld1q_f32(offsetValues);
+        float32x4_t gainLeft = vmlaq_n_f32(vdupq_n_f32(startLeft), offsets, stepLeft);
+        float32x4_t gainRight = vmlaq_n_f32(vdupq_n_f32(startRight), offsets, stepRight);
+        const float32x4_t gainStepLeft = vdupq_n_f32(stepLeft * 4.0f);
+        const float32x4_t gainStepRight = vdupq_n_f32(stepRight * 4.0f);
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            const int i = v * 4;
+            vst1q_f32(destLeft + i, vmlaq_f32(vld1q_f32(destLeft + i), vld1q_f32(srcLeft + i), gainLeft));
+            vst1q_f32(destRight + i, vmlaq_f32(vld1q_f32(destRight + i), vld1q_f32(srcRight + i), gainRight));
+            gainLeft = vaddq_f32(gainLeft, gainStepLeft);
+            gainRight = vaddq_f32(gainRight, gainStepRight);
+        }
+        const int done = numVectors * 4;
+       #else
+        const int done = 0;
+       #endif
+
+        addRampedScalar(destLeft, srcLeft, done, numSamples, startLeft, stepLeft);
+        addRampedScalar(destRight, srcRight, done, numSamples, startRight, stepRight);
+    }
+
+    const char* getImplementationName() noexcept
+    {
+        return SIMD_KERNELS_NAME;
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Inner loops of the mix bus.
+// Each one adds a deck's block onto the bus with a gain that moves linearly from its start to
+// its end value across the block, so a smoothed parameter costs no more than a fixed one.
+// The SIMD path is picked when compiling: AVX, SSE2 or NEON if the target has it, plain C++ otherwise.
+namespace MixKernels
+{
+	// dest[i] += src[i] * gain, the gain ramping from startGain to endGain
+	void addRamped(float* dest, const float* src, int numSamples, float startGain, float endGain) noexcept;
+
+	// Both channels of a stereo deck in a single pass
+	void addRampedStereo(float* destLeft, float* destRight,
+		const float* srcLeft, const float* srcRight, int numSamples,
+		float startLeft, float endLeft, float startRight, float endRight) noexcept;
+
+	// "AVX", "SSE2", "NEON" or "scalar" (see SimdConfig.h)
+	const char* getImplementationName() noexcept;
+}
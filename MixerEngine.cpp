@@ -0,0 +1,186 @@
+#include "MixerEngine.h"
+
+// Renders one deck's block on a pool thread
+class MixerEngine::DeckJob : public juce::ThreadPoolJob
+{
+public:
+    DeckJob(MixerEngine& ownerToUse, int indexToUse)
+        : juce::ThreadPoolJob("Render deck " + juce::String(indexToUse + 1)), owner(ownerToUse), index(indexToUse)
+    {
+    }
+
+    void setNumSamples(int num) noexcept { numSamples = num; }
+
+    JobStatus runJob() override
+    {
+        owner.renderDeck(index, numSamples);
+        return jobHasFinished;
+    }
+
+private:
+    MixerEngine& owner;
+    const int index;
+    int numSamples = 0;
+};
+
+MixerEngine::MixerEngine(int numDecksToCreate)
+{
+    const int numDecks = juce::jlimit(1, maxDecks, numDecksToCreate);
+
+    for (int i = 0; i < numDecks; ++i)
+        decks.add(new PlayerAudio());
+
+    strips.resize((size_t)numDecks);
+}
+
+MixerEngine::~MixerEngine()
+{
+    decks.clear();
+}
+
+void MixerEngine::setRenderThreads(juce::ThreadPool* pool)
+{
+    renderThreads = pool;
+    deckJobs.clear();
+
+    // the first deck renders on the calling thread
+    if (renderThreads != nullptr)
+        for (int i = 1; i < decks.size(); ++i)
+            deckJobs.add(new DeckJob(*this, i));
+}
+
+void MixerEngine::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    profiler.prepare(decks.size(), sampleRate);
+
+    deckBuffers.resize(renderThreads != nullptr ? (size_t)decks.size() : 1);
+    for (auto& buffer : deckBuffers)
+        buffer.setSize(numBusChannels, samplesPerBlockExpected);
+
+    for (int i = 0; i < decks.size(); ++i)
+    {
+        decks[i]->prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+        // start at the current settings rather than gliding from the old ones
+        auto& strip = strips[(size_t)i];
+        const auto [left, right] = getTargetGains(*decks[i]);
+        strip.left.reset(sampleRate, smoothingSeconds);
+        strip.right.reset(sampleRate, smoothingSeconds);
+        strip.left.setCurrentAndTargetValue(left);
+        strip.right.setCurrentAndTargetValue(right);
+    }
+}
+
+void MixerEngine::releaseResources()
+{
+    for (auto* deck : decks)
+        deck->releaseResources();
+}
+
+void MixerEngine::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    bufferToFill.clearActiveBufferRegion();
+
+    auto& output = *bufferToFill.buffer;
+    const int numChannels = juce::jmin(output.getNumChannels(), numBusChannels);
+    const int maxChunk = deckBuffers.empty() ? 0 : deckBuffers.front().getNumSamples();
+
+    if (maxChunk == 0)
+        return;
+
+    profiler.beginBlock();
+
+    // the decks read the clock for their stages only while the profiler wants them
+    for (auto* deck : decks)
+        deck->setStageTiming(profiler.isTimingBlock());
+
+    // a device may hand over a bigger block than it announced; mix it in prepared-size chunks
+    for (int done = 0; done < bufferToFill.numSamples; done += maxChunk)
+    {
+        const int chunk = juce::jmin(maxChunk, bufferToFill.numSamples - done);
+        const int outStart = bufferToFill.startSample + done;
+
+        if (renderThreads == nullptr)
+        {
+            for (int i = 0; i < decks.size(); ++i)
+            {
+                renderDeck(i, chunk);
+                mixDeck(i, output, outStart, chunk, numChannels);
+            }
+            continue;
+        }
+
+        for (auto* job : deckJobs)
+        {
+            job->setNumSamples(chunk);
+            renderThreads->addJob(job, false);
+        }
+
+        renderDeck(0, chunk);
+
+        for (auto* job : deckJobs)
+            renderThreads->waitForJobToFinish(job, -1);
+
+        for (int i = 0; i < decks.size(); ++i)
+            mixDeck(i, output, outStart, chunk, numChannels);
+    }
+
+    profiler.endBlock(bufferToFill.numSamples);
+}
+
+juce::AudioBuffer<float>& MixerEngine::getDeckBuffer(int index) noexcept
+{
+    // rendering one after another, every deck reuses the same buffer while it is still in cache
+    return deckBuffers[renderThreads != nullptr ? (size_t)index : 0];
+}
+
+void MixerEngine::renderDeck(int index, int numSamples) noexcept
+{
+    juce::AudioSourceChannelInfo deckBlock(&getDeckBuffer(index), 0, numSamples);
+    decks.getUnchecked(index)->getNextAudioBlock(deckBlock);
+}
+
+void MixerEngine::mixDeck(int index, juce::AudioBuffer<float>& output, int outStart, int numSamples, int numChannels) noexcept
+{
+    const bool timing = profiler.isTimingBlock();
+    const auto startTicks = timing ? juce::Time::getHighResolutionTicks() : 0;
+    const auto& deckBuffer = getDeckBuffer(index);
+
+    // the gains move linearly across the chunk, landing where the smoothers are after it
+    auto& strip = strips[(size_t)index];
+    const auto [left, right] = getTargetGains(*decks.getUnchecked(index));
+    strip.left.setTargetValue(left);
+    strip.right.setTargetValue(right);
+
+    const float startLeft = strip.left.getCurrentValue();
+    const float startRight = strip.right.getCurrentValue();
+    strip.left.skip(numSamples);
+    strip.right.skip(numSamples);
+
+    if (numChannels == numBusChannels)
+        MixKernels::addRampedStereo(output.getWritePointer(0, outStart), output.getWritePointer(1, outStart),
+            deckBuffer.getReadPointer(0), deckBuffer.getReadPointer(1), numSamples,
+            startLeft, strip.left.getCurrentValue(), startRight, strip.right.getCurrentValue());
+    else if (numChannels == 1)
+        MixKernels::addRamped(output.getWritePointer(0, outStart), deckBuffer.getReadPointer(0), numSamples,
+            startLeft, strip.left.getCurrentValue());
+
+    if (!timing)
+        return;
+
+    auto stages = decks.getUnchecked(index)->getBlockStages();
+    stages[CallbackProfiler::Stage::sum] = juce::Time::getHighResolutionTicks() - startTicks;
+    profiler.addDeck(index, stages);
+}
+
+std::pair<float, float> MixerEngine::getTargetGains(const PlayerAudio& deck) noexcept
+{
+    const float gain = deck.isMuted() ? 0.0f : deck.getGain();
+    const float pan = deck.getPan();
+
+    // balance: both sides at full level in the centre, turning one way fades the other side out
+    const float left = pan > 0.0f ? std::cos(pan * juce::MathConstants<float>::halfPi) : 1.0f;
+    const float right = pan < 0.0f ? std::cos(-pan * juce::MathConstants<float>::halfPi) : 1.0f;
+
+    return { gain * left, gain * right };
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <JuceHeader.h>
+#include "CallbackProfiler.h"
+#include "MixKernels.h"
+#include "PlayerAudio.h"
+
+// Owns every deck and sums them onto the output.
+// The number of decks is fixed when the engine is created, so the audio thread walks a plain
+// array without taking a lock, and the bus buffer is sized in prepareToPlay so mixing never allocates.
+// Each deck's volume, balance and mute are folded into one left and one right gain, smoothed per
+// sample and applied while the deck is added onto the bus, so the whole strip is one pass.
+class MixerEngine : public juce::AudioSource
+{
+public:
+	static constexpr int maxDecks = 32;
+
+	explicit MixerEngine(int numDecksToCreate);
+	~MixerEngine() override;
+
+	int getNumDecks() const noexcept { return decks.size(); }
+	PlayerAudio& getDeck(int index) noexcept { return *decks.getUnchecked(index); }
+
+	// Offline rendering: the decks of each block render at the same time, one on the calling thread and
+	// the others on this pool, before they are mixed in the usual order, so the output is the same as
+	// rendering them one after another. Waiting on the pool isn't real-time safe; leave it null (the
+	// default) when a device drives the mixer. Call before prepareToPlay.
+	void setRenderThreads(juce::ThreadPool* pool);
+
+	// Times each block against its deadline per deck and stage, once enabled
+	CallbackProfiler& getProfiler() noexcept { return profiler; }
+
+	// AudioSource
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+	void releaseResources() override;
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+private:
+	// every deck renders stereo
+	static constexpr int numBusChannels = 2;
+
+	// how long a gain, balance or mute change takes to reach its new value
+	static constexpr double smoothingSeconds = 0.02;
+
+	// Smoothed gains of one deck; audio thread only
+	struct ChannelStrip
+	{
+		juce::LinearSmoothedValue<float> left{ 1.0f };
+		juce::LinearSmoothedValue<float> right{ 1.0f };
+	};
+
+	class DeckJob;
+
+	// left and right gain for the deck's current volume, balance and mute
+	static std::pair<float, float> getTargetGains(const PlayerAudio& deck) noexcept;
+
+	juce::AudioBuffer<float>& getDeckBuffer(int index) noexcept;
+	void renderDeck(int index, int numSamples) noexcept;
+	void mixDeck(int index, juce::AudioBuffer<float>& output, int outStart, int numSamples, int numChannels) noexcept;
+
+	juce::OwnedArray<PlayerAudio> decks;
+	std::vector<ChannelStrip> strips;
+
+	// One deck's block at a time, added onto the output; one per deck when rendering in parallel
+	std::vector<juce::AudioBuffer<float>> deckBuffers;
+
+	juce::ThreadPool* renderThreads = nullptr;
+	juce::OwnedArray<DeckJob> deckJobs;
+
+	CallbackProfiler profiler;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MixerEngine)
+};
@@ -0,0 +1,263 @@
+#include "OfflineRenderer.h"
+#include <iostream>
+
+OfflineRenderer::OfflineRenderer(std::vector<DeckSetup> decksToRender, const Settings& settingsToUse)
+    : decks(std::move(decksToRender)), settings(settingsToUse)
+{
+}
+
+juce::Result OfflineRenderer::render(const std::function<juce::Result(juce::int64 totalSamples)>& begin,
+    const std::function<bool(const juce::AudioBuffer<float>&, int numSamples)>& consume)
+{
+    if (decks.empty() || (int)decks.size() > MixerEngine::maxDecks)
+        return juce::Result::fail("Give between 1 and " + juce::String(MixerEngine::maxDecks) + " files to render");
+
+    if (settings.sampleRate <= 0.0 || settings.blockSize <= 0)
+        return juce::Result::fail("Invalid sample rate or block size");
+
+    const int numDecks = (int)decks.size();
+    const int numThreads = settings.numThreads > 0 ? settings.numThreads
+        : juce::jmin(numDecks, juce::SystemStats::getNumCpus());
+
+    MixerEngine mixer(numDecks);
+
+    // the calling thread renders one deck itself
+    std::unique_ptr<juce::ThreadPool> pool;
+    if (numThreads > 1 && numDecks > 1)
+    {
+        pool = std::make_unique<juce::ThreadPool>(numThreads - 1);
+        mixer.setRenderThreads(pool.get());
+    }
+
+    // the strips start at these rather than gliding to them
+    for (int i = 0; i < numDecks; ++i)
+    {
+        mixer.getDeck(i).setGain(decks[(size_t)i].gain);
+        mixer.getDeck(i).setPan(decks[(size_t)i].pan);
+    }
+
+    mixer.prepareToPlay(settings.blockSize, settings.sampleRate);
+
+    std::vector<juce::int64> startSamples;
+    juce::int64 totalSamples = 0;
+
+    for (int i = 0; i < numDecks; ++i)
+    {
+        const auto& setup = decks[(size_t)i];
+        auto& deck = mixer.getDeck(i);
+
+        deck.setOfflineRendering(true);
+        deck.setResampler(settings.resampler);
+        deck.setSpeed(setup.speed);
+        deck.setKeepPitch(setup.keepPitch);
+
+        if (!deck.loadFileDirect(setup.file))
+            return juce::Result::fail("Can't open " + setup.file.getFullPathName());
+
+        const auto start = (juce::int64)std::llround(juce::jmax(0.0, setup.startSeconds) * settings.sampleRate);
+        startSamples.push_back(start);
+
+        // played out, with a block to spare for what the resampler and time-stretch hold back
+        const double playedSeconds = deck.samplesToSeconds(deck.getTotalLength()) / deck.getSpeed();
+        totalSamples = juce::jmax(totalSamples, start + (juce::int64)std::ceil(playedSeconds * settings.sampleRate) + settings.blockSize);
+    }
+
+    if (settings.lengthSeconds > 0.0)
+        totalSamples = (juce::int64)std::llround(settings.lengthSeconds * settings.sampleRate);
+
+    if (begin)
+    {
+        const auto accepted = begin(totalSamples);
+        if (accepted.failed())
+            return accepted;
+    }
+
+    juce::AudioBuffer<float> block(2, settings.blockSize);
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for (juce::int64 position = 0; position < totalSamples;)
+    {
+        // decks start at the first sample of a block, so blocks are cut short where one comes in
+        auto blockEnd = juce::jmin(totalSamples, position + settings.blockSize);
+        for (int i = 0; i < numDecks; ++i)
+        {
+            if (startSamples[(size_t)i] == position)
+                mixer.getDeck(i).start();
+            else if (startSamples[(size_t)i] > position)
+                blockEnd = juce::jmin(blockEnd, startSamples[(size_t)i]);
+        }
+
+        const int numSamples = (int)(blockEnd - position);
+        mixer.getNextAudioBlock(juce::AudioSourceChannelInfo(&block, 0, numSamples));
+
+        if (!consume(block, numSamples))
+            return juce::Result::fail("Couldn't write the rendered audio");
+
+        position = blockEnd;
+    }
+
+    elapsedSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    renderedSeconds = (double)totalSamples / settings.sampleRate;
+
+    mixer.releaseResources();
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::renderToFile(const juce::File& output, const std::function<void(double)>& progress)
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    auto* format = output.hasFileExtension("wav;flac") ? formats.findFormatForFileExtension(output.getFileExtension()) : nullptr;
+    if (format == nullptr)
+        return juce::Result::fail("The output must be a .wav or .flac file");
+
+    if (!format->getPossibleBitDepths().contains(settings.bitsPerSample))
+        return juce::Result::fail(format->getFormatName() + " can't be written with " + juce::String(settings.bitsPerSample) + " bits");
+
+    output.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream(output.createOutputStream());
+    if (stream == nullptr)
+        return juce::Result::fail("Can't write to " + output.getFullPathName());
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), settings.sampleRate, 2,
+        settings.bitsPerSample, {}, 0));
+    if (writer == nullptr)
+        return juce::Result::fail("Can't create a " + format->getFormatName() + " writer");
+
+    // the writer owns the stream now
+    stream.release();
+
+    juce::int64 total = 0, written = 0;
+    return render([&](juce::int64 totalSamples) { total = totalSamples; return juce::Result::ok(); },
+        [&](const juce::AudioBuffer<float>& block, int numSamples)
+        {
+            if (!writer->writeFromAudioSampleBuffer(block, 0, numSamples))
+                return false;
+
+            written += numSamples;
+            if (progress)
+                progress((double)written / (double)juce::jmax((juce::int64)1, total));
+            return true;
+        });
+}
+
+juce::Result OfflineRenderer::renderToBuffer(juce::AudioBuffer<float>& destination)
+{
+    int written = 0;
+    return render([&](juce::int64 totalSamples)
+        {
+            if (totalSamples > std::numeric_limits<int>::max())
+                return juce::Result::fail("The mix is too long to render into memory; render it to a file instead");
+
+            destination.setSize(2, (int)totalSamples);
+            return juce::Result::ok();
+        },
+        [&](const juce::AudioBuffer<float>& block, int numSamples)
+        {
+            for (int ch = 0; ch < destination.getNumChannels(); ++ch)
+                destination.copyFrom(ch, written, block, ch, 0, numSamples);
+
+            written += numSamples;
+            return true;
+        });
+}
+
+int OfflineRenderer::runFromCommandLine(const juce::ArgumentList& args)
+{
+    const auto cwd = juce::File::getCurrentWorkingDirectory();
+    const auto output = cwd.getChildFile(args.getValueForOption("--render"));
+
+    Settings settings;
+    if (args.containsOption("--rate"))
+        settings.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+    if (args.containsOption("--bits"))
+        settings.bitsPerSample = args.getValueForOption("--bits").getIntValue();
+    if (args.containsOption("--seconds"))
+        settings.lengthSeconds = args.getValueForOption("--seconds").getDoubleValue();
+    if (args.containsOption("--threads"))
+        settings.numThreads = args.getValueForOption("--threads").getIntValue();
+    if (args.containsOption("--block"))
+        settings.blockSize = args.getValueForOption("--block").getIntValue();
+
+    // everything that isn't an option or an option's value is a file, optionally "@" the second it starts at;
+    // the deck options seen so far apply to it
+    std::vector<DeckSetup> decks;
+    DeckSetup nextDeck;
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        if (arg.isOption())
+        {
+            const auto name = arg.text.upToFirstOccurrenceOf("=", false, false);
+            if (name == "--keep-pitch" || name == "--no-keep-pitch")
+            {
+                nextDeck.keepPitch = name == "--keep-pitch";
+                continue;
+            }
+
+            juce::String value;
+            if (arg.text.containsChar('='))
+                value = arg.text.fromFirstOccurrenceOf("=", false, false);
+            else if (++i < args.size())
+                value = args[i].text;
+
+            if (name == "--speed")
+            {
+                nextDeck.speed = value.getDoubleValue();
+                if (nextDeck.speed <= 0.0)
+                {
+                    std::cerr << "--speed needs a ratio above 0" << std::endl;
+                    return 1;
+                }
+            }
+            else if (name == "--gain")
+            {
+                nextDeck.gain = juce::jmax(0.0f, value.getFloatValue());
+            }
+            else if (name == "--pan")
+            {
+                nextDeck.pan = juce::jlimit(-1.0f, 1.0f, value.getFloatValue());
+            }
+
+            continue;
+        }
+
+        DeckSetup deck = nextDeck;
+        auto path = arg.text;
+        const int at = path.lastIndexOfChar('@');
+        if (at > 0 && path.substring(at + 1).containsOnly("0123456789."))
+        {
+            deck.startSeconds = path.substring(at + 1).getDoubleValue();
+            path = path.substring(0, at);
+        }
+
+        deck.file = cwd.getChildFile(path);
+        decks.push_back(deck);
+    }
+
+    OfflineRenderer renderer(std::move(decks), settings);
+
+    int lastTenth = 0;
+    const auto result = renderer.renderToFile(output, [&lastTenth](double done)
+        {
+            const int tenth = (int)(done * 10.0);
+            if (tenth > lastTenth)
+            {
+                lastTenth = tenth;
+                std::cout << tenth * 10 << "%" << std::endl;
+            }
+        });
+
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    const double speed = renderer.getRenderedSeconds() / juce::jmax(1.0e-9, renderer.getElapsedSeconds());
+    std::cout << "Rendered " << juce::String(renderer.getRenderedSeconds(), 1) << " s in "
+        << juce::String(renderer.getElapsedSeconds(), 2) << " s (" << juce::String(speed, 1)
+        << "x real time) to " << output.getFullPathName() << std::endl;
+    return 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <JuceHeader.h>
+#include "MixerEngine.h"
+
+// Drives decks through the mixer without an audio device, as fast as the CPU allows, and writes
+// the mix to a WAV or FLAC file. The decks render on several threads at once, and every file is
+// decoded on the thread that renders it, so the same setup always gives the same samples; that
+// also makes it the harness for deterministic tests and benchmarks.
+// Started from the command line with "--render"; see runFromCommandLine().
+class OfflineRenderer
+{
+public:
+	struct DeckSetup
+	{
+		juce::File file;
+		double startSeconds = 0.0; // where in the mix the deck starts playing
+		float gain = 1.0f;
+		float pan = 0.0f;
+		double speed = 1.0;
+		bool keepPitch = false;
+	};
+
+	struct Settings
+	{
+		double sampleRate = 44100.0;
+		int blockSize = 4096;
+		int bitsPerSample = 24;
+		double lengthSeconds = 0.0; // 0 renders until every deck has played out
+		int numThreads = 0; // 0 uses one per deck, up to the number of cores
+		PlayerAudio::Resampler resampler = PlayerAudio::Resampler::sinc;
+	};
+
+	OfflineRenderer(std::vector<DeckSetup> decksToRender, const Settings& settingsToUse);
+
+	// Renders to a .wav or .flac file, chosen by the extension. progress is called after every block
+	// with the fraction done.
+	juce::Result renderToFile(const juce::File& output, const std::function<void(double)>& progress = nullptr);
+
+	// Renders into a stereo buffer, resized to the length of the mix; fails if the mix is longer
+	// than a buffer can hold
+	juce::Result renderToBuffer(juce::AudioBuffer<float>& destination);
+
+	// Seconds of audio and wall-clock seconds of the last render
+	double getRenderedSeconds() const noexcept { return renderedSeconds; }
+	double getElapsedSeconds() const noexcept { return elapsedSeconds; }
+
+	// "--render out.wav [--rate R] [--bits B] [--seconds S] [--threads N] [--block B] [deck options] file[@startSeconds] ..."
+	// Deck options set up every file after them: --speed X, --gain G (linear), --pan P (-1 .. 1) and
+	// --keep-pitch or --no-keep-pitch. Prints what it did and returns the process exit code.
+	static int runFromCommandLine(const juce::ArgumentList& args);
+
+private:
+	// Renders block by block, handing each one to the consumer, which returns false to stop with a write error.
+	// begin is told the length of the mix first and can refuse it.
+	juce::Result render(const std::function<juce::Result(juce::int64 totalSamples)>& begin,
+		const std::function<bool(const juce::AudioBuffer<float>&, int numSamples)>& consume);
+
+	std::vector<DeckSetup> decks;
+	Settings settings;
+	double renderedSeconds = 0.0;
+	double elapsedSeconds = 0.0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineRenderer)
+};
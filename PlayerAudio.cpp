@@ -1,235 +1,1078 @@
 ﻿#include "PlayerAudio.h"
 
+namespace
+{
+    // Gains of the incoming and outgoing track at t (0..1) through a crossfade
+    void getCrossfadeGains(PlaylistCrossfade::Curve curve, float t, float& fadeIn, float& fadeOut) noexcept
+    {
+        switch (curve)
+        {
+        case PlaylistCrossfade::Curve::linear:
+            fadeIn = t;
+            break;
+
+        case PlaylistCrossfade::Curve::sCurve:
+            fadeIn = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::pi * t);
+            break;
+
+        case PlaylistCrossfade::Curve::equalPower:
+            // the powers add up to one, so uncorrelated material keeps its loudness
+            fadeIn = std::sin(juce::MathConstants<float>::halfPi * t);
+            fadeOut = std::cos(juce::MathConstants<float>::halfPi * t);
+            return;
+        }
+
+        fadeOut = 1.0f - fadeIn;
+    }
+
+    float getLoudestSample(const juce::AudioBuffer<float>& buffer, int index) noexcept
+    {
+        float loudest = 0.0f;
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            loudest = juce::jmax(loudest, std::abs(buffer.getSample(ch, index)));
+        return loudest;
+    }
+
+    // First sample at or above the threshold within the first maxSamples, or 0 if there is none
+    juce::int64 findAudibleStart(juce::AudioFormatReader& reader, float threshold, juce::int64 maxSamples)
+    {
+        const int chunkSize = 8192;
+        juce::AudioBuffer<float> buffer((int)juce::jlimit(1u, 2u, reader.numChannels), chunkSize);
+        const auto limit = juce::jmin(reader.lengthInSamples, maxSamples);
+
+        for (juce::int64 pos = 0; pos < limit; pos += chunkSize)
+        {
+            const int num = (int)juce::jmin((juce::int64)chunkSize, limit - pos);
+            reader.read(&buffer, 0, num, pos, true, buffer.getNumChannels() > 1);
+
+            for (int i = 0; i < num; ++i)
+                if (getLoudestSample(buffer, i) >= threshold)
+                    return pos + i;
+        }
+
+        return 0;
+    }
+
+    // One past the last sample at or above the threshold within the last maxSamples, or the length if there is none
+    juce::int64 findAudibleEnd(juce::AudioFormatReader& reader, float threshold, juce::int64 maxSamples)
+    {
+        const int chunkSize = 8192;
+        juce::AudioBuffer<float> buffer((int)juce::jlimit(1u, 2u, reader.numChannels), chunkSize);
+        const auto limit = juce::jmax((juce::int64)0, reader.lengthInSamples - maxSamples);
+
+        for (auto end = reader.lengthInSamples; end > limit; end -= chunkSize)
+        {
+            const auto start = juce::jmax(limit, end - chunkSize);
+            const int num = (int)(end - start);
+            reader.read(&buffer, 0, num, start, true, buffer.getNumChannels() > 1);
+
+            for (int i = num; --i >= 0;)
+                if (getLoudestSample(buffer, i) >= threshold)
+                    return start + i + 1;
+        }
+
+        return reader.lengthInSamples;
+    }
+}
+
+// Opens a file to load into the deck without blocking the message thread
+class PlayerAudio::LoadJob : public juce::ThreadPoolJob
+{
+public:
+    LoadJob(PlayerAudio& ownerToUse, const juce::File& fileToOpen, std::function<void(bool)> onDoneToUse, int requestIdToUse)
+        : juce::ThreadPoolJob("Load " + fileToOpen.getFileName()),
+          owner(ownerToUse), weakOwner(&ownerToUse), file(fileToOpen), onDone(std::move(onDoneToUse)), requestId(requestIdToUse)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        // hand the track over in a shared holder so it is freed even if the callback never runs
+        auto holder = std::make_shared<std::unique_ptr<DeckTrack>>(owner.createTrack(file));
+
+        if (shouldExit())
+            return jobHasFinished;
+
+        juce::MessageManager::callAsync([weak = weakOwner, holder, callback = std::move(onDone), id = requestId]()
+            {
+                if (auto* audio = weak.get())
+                    audio->loadedTrackReady(std::move(*holder), id, callback);
+            });
+
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const PlayerAudio* audio) const noexcept { return &owner == audio; }
+
+private:
+    PlayerAudio& owner;
+    juce::WeakReference<PlayerAudio> weakOwner;
+    juce::File file;
+    std::function<void(bool)> onDone;
+    int requestId;
+};
+
+// Opens the file that should follow the current one without touching the message thread,
+// and works out where the crossfade into it begins
+class PlayerAudio::PreloadJob : public juce::ThreadPoolJob
+{
+public:
+    PreloadJob(PlayerAudio& ownerToUse, const juce::File& fileToOpen, const PlaylistCrossfade& crossfadeToUse,
+        const juce::File& currentFileToUse, double currentSampleRateToUse, int requestIdToUse)
+        : juce::ThreadPoolJob("Preload " + fileToOpen.getFileName()),
+          owner(ownerToUse), weakOwner(&ownerToUse), file(fileToOpen), crossfade(crossfadeToUse),
+          currentFile(currentFileToUse), currentSampleRate(currentSampleRateToUse), requestId(requestIdToUse)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        // hand the track over in a shared holder so it is freed even if the callback never runs
+        auto holder = std::make_shared<std::unique_ptr<DeckTrack>>(owner.createTrack(file));
+
+        juce::int64 startPosition = 0;
+        juce::int64 mixPoint = 0;
+        if (*holder != nullptr && crossfade.seconds > 0.0)
+            findMixPoints(startPosition, mixPoint);
+
+        if (shouldExit())
+            return jobHasFinished;
+
+        juce::MessageManager::callAsync([weak = weakOwner, holder, startPosition, mixPoint, id = requestId]()
+            {
+                if (auto* audio = weak.get())
+                    audio->nextTrackReady(std::move(*holder), startPosition, mixPoint, id);
+            });
+
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const PlayerAudio* audio) const noexcept { return &owner == audio; }
+
+private:
+    void findMixPoints(juce::int64& startPosition, juce::int64& mixPoint)
+    {
+        // readers of their own, so the decks' read-ahead isn't disturbed
+        std::unique_ptr<juce::AudioFormatReader> current(owner.formatManager.createReaderFor(currentFile));
+        if (current == nullptr)
+            return;
+
+        auto end = current->lengthInSamples;
+
+        if (crossfade.detectSilence)
+        {
+            const auto threshold = juce::Decibels::decibelsToGain(crossfade.silenceThresholdDb);
+            end = findAudibleEnd(*current, threshold, (juce::int64)(maxSilenceSeconds * current->sampleRate));
+
+            std::unique_ptr<juce::AudioFormatReader> next(owner.formatManager.createReaderFor(file));
+            if (next != nullptr)
+                startPosition = findAudibleStart(*next, threshold, (juce::int64)(maxSilenceSeconds * next->sampleRate));
+        }
+
+        mixPoint = juce::jmax((juce::int64)0, end - (juce::int64)(crossfade.seconds * currentSampleRate));
+    }
+
+    // silence longer than this is taken to be part of the track
+    static constexpr double maxSilenceSeconds = 30.0;
+
+    PlayerAudio& owner;
+    juce::WeakReference<PlayerAudio> weakOwner;
+    juce::File file;
+    PlaylistCrossfade crossfade;
+    juce::File currentFile;
+    double currentSampleRate;
+    int requestId;
+};
+
+// Decodes the audio after each hot cue of a streamed track
+class PlayerAudio::HotCueJob : public juce::ThreadPoolJob
+{
+public:
+    HotCueJob(PlayerAudio& ownerToUse, DeckTrack* trackToUse, std::vector<juce::int64> cuesToUse,
+        int snippetLengthToUse, std::vector<HotCueBank::SnippetPtr> reusableSnippets, int requestIdToUse)
+        : juce::ThreadPoolJob("Hot cues " + trackToUse->file.getFileName()),
+          owner(ownerToUse), weakOwner(&ownerToUse), file(trackToUse->file), track(trackToUse),
+          cues(std::move(cuesToUse)), snippetLength(snippetLengthToUse),
+          reusable(std::move(reusableSnippets)), requestId(requestIdToUse)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        // a reader of its own, so the deck's read-ahead isn't disturbed
+        std::unique_ptr<juce::AudioFormatReader> reader(owner.formatManager.createReaderFor(file));
+        if (reader == nullptr)
+            return jobHasFinished;
+
+        auto bank = HotCueBank::build(*reader, cues, snippetLength, reusable, [this] { return shouldExit(); });
+        if (bank == nullptr)
+            return jobHasFinished;
+
+        auto holder = std::make_shared<std::unique_ptr<HotCueBank>>(std::move(bank));
+        juce::MessageManager::callAsync([weak = weakOwner, holder, target = track, id = requestId]()
+            {
+                if (auto* audio = weak.get())
+                    audio->hotCueBankReady(std::move(*holder), target, id);
+            });
+
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const PlayerAudio* audio) const noexcept { return &owner == audio; }
+
+private:
+    PlayerAudio& owner;
+    juce::WeakReference<PlayerAudio> weakOwner;
+    juce::File file;
+    DeckTrack* track; // only compared, never dereferenced here
+    std::vector<juce::int64> cues;
+    int snippetLength;
+    std::vector<HotCueBank::SnippetPtr> reusable;
+    int requestId;
+};
+
 PlayerAudio::PlayerAudio()
 {
     formatManager.registerBasicFormats();
+
+    readAheadThread = &decodeThreads->getNextReadAheadThread();
 }
 
 PlayerAudio::~PlayerAudio()
 {
-    if (resamplingSource)
+    // wait for any load or preload still using this object
+    struct OwnJobs : public juce::ThreadPool::JobSelector
     {
-        resamplingSource->releaseResources();
-        resamplingSource.reset();
-    }
+        const PlayerAudio* audio;
+        explicit OwnJobs(const PlayerAudio* a) : audio(a) {}
+        bool isJobSuitable(juce::ThreadPoolJob* job) override
+        {
+            if (auto* load = dynamic_cast<LoadJob*>(job))
+                return load->belongsTo(audio);
+            if (auto* preload = dynamic_cast<PreloadJob*>(job))
+                return preload->belongsTo(audio);
+            if (auto* hotCues = dynamic_cast<HotCueJob*>(job))
+                return hotCues->belongsTo(audio);
+            return false;
+        }
+    } ownJobs(this);
+    decodeThreads->getJobPool().removeAllJobs(true, 4000, &ownJobs);
 
-    transportSource.stop();
-    transportSource.setSource(nullptr);
-    readerSource.reset();
+    // nothing renders any more, so settle what is still in flight; the voices and the handover free their own tracks
+    {
+        const juce::SpinLock::ScopedLockType sl(commandLock);
+        applyPendingCommands();
+        finishCrossfade();
+    }
+    collectRetiredTracks();
 }
 
 void PlayerAudio::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
-    transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    const juce::SpinLock::ScopedLockType sl(commandLock);
+
+    realtime.deviceSampleRate = sampleRate;
+    for (auto& voice : voices)
+        voice.prepareToPlay(samplesPerBlockExpected, sampleRate);
 
-    if (!resamplingSource)
-        resamplingSource = std::make_unique<juce::ResamplingAudioSource>(&transportSource, false, 2);
+    // the outgoing voice renders here during a crossfade, in pieces if a block is larger
+    crossfadeBuffer.setSize(2, juce::jmax(256, samplesPerBlockExpected));
 
-    resamplingSource->prepareToPlay(samplesPerBlockExpected, sampleRate);
-    resamplingSource->setResamplingRatio(speedRatio);
+    prepared = true;
 }
 
 void PlayerAudio::releaseResources()
 {
-    if (resamplingSource)
-        resamplingSource->releaseResources();
+    const juce::SpinLock::ScopedLockType sl(commandLock);
 
-    transportSource.releaseResources();
+    prepared = false;
+    for (auto& voice : voices)
+        voice.releaseResources();
 }
 
-void PlayerAudio::loadFileAsync()
+void PlayerAudio::setStageTiming(bool shouldTime) noexcept
 {
-    juce::FileChooser chooser("Select an audio file...", juce::File{}, "*.mp3;*.wav");
+    if (stageTiming == shouldTime)
+        return;
 
-    chooser.launchAsync(juce::FileBrowserComponent::openMode,
-        [this](const juce::FileChooser& fc)
-        {
-            auto file = fc.getResult();
-            if (file.existsAsFile())
-                loadFile(file);
-        });
+    stageTiming = shouldTime;
+    blockStages.clear();
+    for (auto& voice : voices)
+        voice.setStageTiming(shouldTime);
 }
 
+void PlayerAudio::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    if (!stageTiming)
+    {
+        renderBlock(bufferToFill);
+        return;
+    }
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    renderBlock(bufferToFill);
+
+    blockStages.clear();
+    for (auto& voice : voices)
+        voice.takeStageTicks(blockStages);
+
+    // whatever the voices don't account for is the deck's own work
+    blockStages[CallbackProfiler::Stage::gain] = juce::Time::getHighResolutionTicks() - startTicks - blockStages.getTotal();
+}
 
-void PlayerAudio::loadFileDirect(const juce::File& file)
+void PlayerAudio::renderBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-    if (!file.existsAsFile())
+    const juce::SpinLock::ScopedTryLockType sl(commandLock);
+    if (!sl.isLocked())
+    {
+        // the message thread is applying changes itself while the device starts or stops
+        bufferToFill.clearActiveBufferRegion();
         return;
+    }
 
-    trackTitle.clear();
-    trackArtist.clear();
-    trackAlbum.clear();
+    applyPendingCommands();
 
-    TagLib::FileRef f(file.getFullPathName().toRawUTF8());
-    if (!f.isNull() && f.tag())
+    // crossfade into the queued track once the current one reaches its mix point
+    if (realtime.playing && realtime.playlistCrossfadeSeconds > 0.0 && realtime.fadingVoice < 0 && handover.hasNextTrack())
     {
-        auto tag = f.tag();
-        juce::String title = juce::String::fromUTF8(tag->title().toCString(true));
-        juce::String artist = juce::String::fromUTF8(tag->artist().toCString(true));
-        juce::String album = juce::String::fromUTF8(tag->album().toCString(true));
-        trackTitle = title;
-        trackArtist = artist;
-        trackAlbum = album;
+        const auto& current = voices[realtime.activeVoice];
+        auto* track = current.getTrackQueue().getCurrentTrack();
+
+        if (track != nullptr && !current.getTrackQueue().isLooping() && !track->loopSource->isRegionActive()
+            && current.getPlayedPosition() >= handover.getMixPoint())
+            startPlaylistCrossfade();
     }
 
-    if (auto* reader = formatManager.createReaderFor(file))
+    const bool isRendering = realtime.playing;
+    if (!isRendering && realtime.fadeGain == 0.0f && realtime.fadingVoice < 0)
+    {
+        bufferToFill.clearActiveBufferRegion();
+        publishTelemetry(nullptr);
+        return;
+    }
+
+    auto& voice = voices[realtime.activeVoice];
+
+    if (isRendering || realtime.fadeGain > 0.0f)
+    {
+        voice.getNextAudioBlock(bufferToFill);
+
+        // fade in over the first block after starting, or out over the block after stopping;
+        // volume, balance and mute are applied by the mix bus
+        const float targetFade = isRendering ? 1.0f : 0.0f;
+        if (targetFade != realtime.fadeGain)
+            bufferToFill.buffer->applyGainRamp(bufferToFill.startSample, bufferToFill.numSamples, realtime.fadeGain, targetFade);
+        realtime.fadeGain = targetFade;
+    }
+    else
     {
-        transportSource.stop();
-        transportSource.setSource(nullptr);
-        readerSource.reset();
+        bufferToFill.clearActiveBufferRegion();
+    }
 
-        readerSource = std::make_unique<juce::AudioFormatReaderSource>(reader, true);
-        transportSource.setSource(readerSource.get(), 0, nullptr, reader->sampleRate);
+    if (realtime.fadingVoice >= 0)
+        renderCrossfade(bufferToFill);
 
-        currentFile = file;
+    if (realtime.jumpRequestTicks != 0)
+    {
+        const auto ticks = juce::Time::getHighResolutionTicks() - realtime.jumpRequestTicks;
+        realtime.lastJumpLatencyMs = (float)(juce::Time::highResolutionTicksToSeconds(ticks) * 1000.0);
+        realtime.jumpRequestTicks = 0;
+    }
 
-        if (resamplingSource)
-            resamplingSource->setResamplingRatio(speedRatio);
+    // stop once the last track has played out
+    if (isRendering && !voice.getTrackQueue().isLooping()
+        && voice.getPlayedPosition() > voice.getTrackQueue().getTotalLength() + 1)
+    {
+        realtime.playing = false;
+        realtime.streamFinished = true;
     }
+
+    publishTelemetry(&bufferToFill);
 }
 
+void PlayerAudio::publishTelemetry(const juce::AudioSourceChannelInfo* renderedBlock) noexcept
+{
+    auto& snapshot = telemetry.getWriteBuffer();
+    const auto& voice = voices[realtime.activeVoice];
+    const auto& trackQueue = voice.getTrackQueue();
+    auto* track = trackQueue.getCurrentTrack();
 
-void PlayerAudio::loadFile(const juce::File& file)
+    snapshot.positionSamples = voice.getPlayedPosition();
+    snapshot.lengthSamples = trackQueue.getTotalLength();
+    snapshot.sampleRate = track != nullptr ? track->sampleRate : 0.0;
+    snapshot.playing = realtime.playing;
+    snapshot.streamFinished = realtime.streamFinished;
+    snapshot.looping = trackQueue.isLooping();
+    snapshot.regionLooping = track != nullptr && track->loopSource->isRegionActive();
+    snapshot.underruns = underrunCount.load(std::memory_order_relaxed);
+    snapshot.keepPitch = voice.isKeepingPitch();
+    snapshot.lastJumpLatencyMs = realtime.lastJumpLatencyMs;
+    snapshot.lastJumpResident = realtime.lastJumpResident;
+    snapshot.stretchLoad = voice.getStretchLoad();
+
+    for (int ch = 0; ch < DeckTelemetry::maxChannels; ++ch)
+    {
+        const bool hasLevels = renderedBlock != nullptr && ch < renderedBlock->buffer->getNumChannels();
+        snapshot.peak[ch] = hasLevels ? renderedBlock->buffer->getMagnitude(ch, renderedBlock->startSample, renderedBlock->numSamples) : 0.0f;
+        snapshot.rms[ch] = hasLevels ? renderedBlock->buffer->getRMSLevel(ch, renderedBlock->startSample, renderedBlock->numSamples) : 0.0f;
+    }
+
+    telemetry.publish();
+}
+
+void PlayerAudio::sendCommand(const Command& command)
 {
-    if (!file.existsAsFile())
+    collectRetiredTracks();
+
+    if (!prepared.load())
+    {
+        // no device is pulling audio from this deck, so nothing can race with applying it here;
+        // holding the lock makes a device that starts meanwhile wait (or output silence) until we're done
+        const juce::SpinLock::ScopedLockType sl(commandLock);
+        if (!prepared.load())
+        {
+            applyPendingCommands();
+            applyCommand(command);
+            publishTelemetry(nullptr);
+            collectRetiredTracks();
+            return;
+        }
+    }
+
+    if (!commands.push(command))
+    {
+        // the audio thread hasn't drained the queue for hundreds of commands
+        jassertfalse;
+        if (command.type == Command::Type::loadTrack)
+        {
+            if (loadedTrack == command.track)
+                loadedTrack = nullptr;
+            delete command.track;
+        }
+        delete command.cueBank;
+    }
+}
+
+void PlayerAudio::applyPendingCommands() noexcept
+{
+    Command command;
+    while (commands.pop(command))
+        applyCommand(command);
+}
+
+void PlayerAudio::applyCommand(const Command& command) noexcept
+{
+    auto& voice = voices[realtime.activeVoice];
+    auto* track = voice.getTrackQueue().getCurrentTrack();
+
+    switch (command.type)
+    {
+    case Command::Type::start:
+        if (voice.getTrackQueue().getTotalLength() > 0)
+        {
+            // started together with a crossfade that hasn't begun yet: come in along its curve
+            if (realtime.fadingVoice >= 0 && realtime.crossfadePosition == 0 && !realtime.playing)
+            {
+                realtime.crossfadeIn = true;
+                realtime.fadeGain = 1.0f;
+            }
+
+            realtime.streamFinished = false;
+            realtime.playing = true;
+        }
+        break;
+
+    case Command::Type::stop:
+        realtime.playing = false;
+        break;
+
+    case Command::Type::setPosition:
+        if (track != nullptr)
+            voice.setPosition(command.position);
+        break;
+
+    // settings apply to both voices, so the one a track is loaded into next already has them
+    case Command::Type::setSpeed:
+        for (auto& v : voices)
+            v.setSpeed(command.value);
+        break;
+
+    case Command::Type::setKeepPitch:
+        for (auto& v : voices)
+            v.setKeepPitch(command.flag);
+        break;
+
+    case Command::Type::setStretchQuality:
+        for (auto& v : voices)
+            v.setStretchQuality((TimeStretchSource::Quality)(int)command.value);
+        break;
+
+    case Command::Type::setResampler:
+        for (auto& v : voices)
+            v.setResampler((Resampler)(int)command.value);
+        break;
+
+    case Command::Type::jumpToSample:
+        if (track != nullptr)
+        {
+            const auto position = command.position;
+            voice.setPosition(position);
+
+            // the latency is taken once the first block from the cue has been rendered
+            realtime.jumpRequestTicks = command.timestamp;
+            realtime.lastJumpResident = track->hotCues == nullptr || track->hotCues->isResident(position);
+        }
+        break;
+
+    case Command::Type::setHotCueBank:
+    {
+        // a bank built for a track that has since been replaced is thrown away
+        HotCueBank* replaced = command.cueBank;
+        if (track != nullptr && track == command.track && track->hotCues != nullptr)
+            replaced = track->hotCues->swapBank(command.cueBank);
+
+        if (replaced != nullptr)
+        {
+            const bool pushed = retiredCueBanks.push(replaced);
+            jassertquiet(pushed);
+        }
+        break;
+    }
+
+    case Command::Type::setLooping:
+        voice.getTrackQueue().setLooping(command.flag);
+        break;
+
+    case Command::Type::setRegion:
+        if (track != nullptr)
+            track->loopSource->setRegion(command.flag, command.regionStart, command.regionEnd);
+        break;
+
+    case Command::Type::setPlaylistCrossfade:
+        realtime.playlistCrossfadeSeconds = command.value;
+        realtime.playlistCurve = command.curve;
+        updateCanStartNext();
+        break;
+
+    case Command::Type::loadTrack:
+    case Command::Type::unloadTrack:
+        loadIntoIdleVoice(command);
+        ++loadsApplied;
+        break;
+    }
+}
+
+void PlayerAudio::loadIntoIdleVoice(const Command& command) noexcept
+{
+    // a crossfade still running is cut short, freeing the voice it was playing out on
+    finishCrossfade();
+
+    auto& outgoing = voices[realtime.activeVoice];
+    const bool audible = (realtime.playing || realtime.fadeGain > 0.0f) && outgoing.getTrackQueue().getCurrentTrack() != nullptr;
+
+    realtime.activeVoice = 1 - realtime.activeVoice;
+    auto& incoming = voices[realtime.activeVoice];
+
+    retireTrack(incoming.getTrackQueue().swapCurrentTrack(command.track));
+    incoming.flush();
+    incoming.updateRatio();
+
+    realtime.crossfadeLength = (int)(command.value * realtime.deviceSampleRate);
+    if (audible && realtime.crossfadeLength > 0)
+    {
+        // the old track keeps playing from where it is and fades out under the new one
+        realtime.fadingVoice = 1 - realtime.activeVoice;
+        realtime.crossfadePosition = 0;
+        realtime.crossfadeIn = false;
+        realtime.crossfadeCurve = PlaylistCrossfade::Curve::equalPower;
+    }
+    else
+    {
+        retireTrack(outgoing.getTrackQueue().swapCurrentTrack(nullptr));
+    }
+
+    updateCanStartNext();
+    realtime.playing = false;
+    realtime.streamFinished = false;
+    realtime.fadeGain = 0.0f;
+}
+
+void PlayerAudio::startPlaylistCrossfade() noexcept
+{
+    realtime.crossfadeLength = (int)(realtime.playlistCrossfadeSeconds * realtime.deviceSampleRate);
+    if (realtime.crossfadeLength <= 0)
+        return;
+
+    // nothing is handed back: the outgoing track is retired once it has faded out
+    auto* following = handover.startNextTrack(nullptr);
+    if (following == nullptr)
+        return;
+
+    realtime.fadingVoice = realtime.activeVoice;
+    realtime.activeVoice = 1 - realtime.activeVoice;
+
+    auto& incoming = voices[realtime.activeVoice];
+    retireTrack(incoming.getTrackQueue().swapCurrentTrack(following));
+    incoming.flush();
+    incoming.updateRatio();
+
+    realtime.crossfadePosition = 0;
+    realtime.crossfadeIn = true;
+    realtime.crossfadeCurve = realtime.playlistCurve;
+    updateCanStartNext();
+}
+
+void PlayerAudio::updateCanStartNext() noexcept
+{
+    // with a crossfade set, only startPlaylistCrossfade() moves on, and never from a voice fading out
+    for (int i = 0; i < 2; ++i)
+        voices[i].getTrackQueue().setCanStartNext(i == realtime.activeVoice && realtime.playlistCrossfadeSeconds <= 0.0);
+}
+
+void PlayerAudio::renderCrossfade(const juce::AudioSourceChannelInfo& bufferToFill) noexcept
+{
+    auto& outgoing = voices[realtime.fadingVoice];
+    auto& output = *bufferToFill.buffer;
+    const int numChannels = juce::jmin(output.getNumChannels(), crossfadeBuffer.getNumChannels());
+
+    // the curves are applied as short linear ramps
+    auto gainsAt = [this](int position, float& fadeIn, float& fadeOut)
+        {
+            const float t = (float)juce::jmin(position, realtime.crossfadeLength) / (float)realtime.crossfadeLength;
+            getCrossfadeGains(realtime.crossfadeCurve, t, fadeIn, fadeOut);
+        };
+
+    if (realtime.crossfadeIn && !realtime.playing)
+    {
+        // stopped during a playlist crossfade: both tracks fade out over this block from where the curves are
+        float fadeIn, fadeOut;
+        gainsAt(realtime.crossfadePosition, fadeIn, fadeOut);
+
+        const int num = juce::jmin(bufferToFill.numSamples, crossfadeBuffer.getNumSamples());
+        juce::AudioSourceChannelInfo tail(&crossfadeBuffer, 0, num);
+        outgoing.getNextAudioBlock(tail);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            output.applyGain(ch, bufferToFill.startSample, bufferToFill.numSamples, fadeIn);
+            output.addFromWithRamp(ch, bufferToFill.startSample, crossfadeBuffer.getReadPointer(ch), num, fadeOut, 0.0f);
+        }
+
+        finishCrossfade();
         return;
-	// Reset metadata
-    trackTitle.clear();
-    trackArtist.clear();
-    trackAlbum.clear();
+    }
+
+    const int rampSize = 32;
+    int done = 0;
 
-    TagLib::FileRef f(file.getFullPathName().toRawUTF8());
-    if (!f.isNull() && f.tag())
+    while (done < bufferToFill.numSamples && realtime.crossfadePosition < realtime.crossfadeLength)
     {
-        auto tag = f.tag();
+        const int num = juce::jmin(bufferToFill.numSamples - done, crossfadeBuffer.getNumSamples(),
+            realtime.crossfadeLength - realtime.crossfadePosition);
 
-        juce::String title = juce::String::fromUTF8(tag->title().toCString(true));
-        juce::String artist = juce::String::fromUTF8(tag->artist().toCString(true));
-        juce::String album = juce::String::fromUTF8(tag->album().toCString(true));
+        juce::AudioSourceChannelInfo tail(&crossfadeBuffer, 0, num);
+        outgoing.getNextAudioBlock(tail);
 
-        trackTitle = title;
-        trackArtist = artist;
-        trackAlbum = album;
+        for (int pos = 0; pos < num; pos += rampSize)
+        {
+            const int rampLength = juce::jmin(rampSize, num - pos);
+            float startIn, startOut, endIn, endOut;
+            gainsAt(realtime.crossfadePosition + pos, startIn, startOut);
+            gainsAt(realtime.crossfadePosition + pos + rampLength, endIn, endOut);
+            const int outputStart = bufferToFill.startSample + done + pos;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                if (realtime.crossfadeIn)
+                    output.applyGainRamp(ch, outputStart, rampLength, startIn, endIn);
+
+                output.addFromWithRamp(ch, outputStart, crossfadeBuffer.getReadPointer(ch, pos), rampLength,
+                    startOut, endOut);
+            }
+        }
+
+        realtime.crossfadePosition += num;
+        done += num;
     }
 
+    if (realtime.crossfadePosition >= realtime.crossfadeLength)
+        finishCrossfade();
+}
+
+void PlayerAudio::finishCrossfade() noexcept
+{
+    if (realtime.fadingVoice < 0)
+        return;
 
+    retireTrack(voices[realtime.fadingVoice].getTrackQueue().swapCurrentTrack(nullptr));
+    realtime.fadingVoice = -1;
+    realtime.crossfadeIn = false;
+    updateCanStartNext();
+}
 
+void PlayerAudio::retireTrack(DeckTrack* track) noexcept
+{
+    if (track != nullptr)
+    {
+        const bool pushed = retiredTracks.push(track);
+        jassertquiet(pushed);
+    }
+}
 
-    if (auto* reader = formatManager.createReaderFor(file))
+void PlayerAudio::collectRetiredTracks()
+{
+    // closing a file can wait on its read-ahead thread, so that happens on the disposal thread
+    DeckTrack* track = nullptr;
+    while (retiredTracks.pop(track))
     {
-        transportSource.stop();
-        transportSource.setSource(nullptr);
-        readerSource.reset();
+        // a playlist crossfade (cut short by a stop, say) retired the track still known as loaded here
+        // before handleTrackAdvance() collected the switch: move on to the track that replaced it
+        if (track == loadedTrack)
+        {
+            loadedTrack = handover.getLastStartedTrack();
+            forgetHotCues();
+        }
+
+        decodeThreads->dispose(std::unique_ptr<DeckTrack>(track));
+    }
+
+    HotCueBank* bank = nullptr;
+    while (retiredCueBanks.pop(bank))
+        decodeThreads->dispose(std::unique_ptr<HotCueBank>(bank));
+}
+
+juce::AudioFormatReader* PlayerAudio::createReader(const juce::File& file)
+{
+    // a file still decoding into RAM reads as silence, which an offline render must not wait around for
+    if (ramPreload && !offlineRendering)
+        if (auto preloaded = sampleCache->get(file, ramPreloadFormat))
+            return new PreloadedAudioReader(preloaded, underrunCount);
+
+    // uncompressed WAV and AIFF play straight from a mapping of the file
+    if (auto* format = formatManager.findFormatForFileExtension(file.getFileExtension()))
+        if (auto mapped = MappedPcmReader::create(*format, file, *readAheadThread, readAheadSeconds))
+            return mapped.release();
+
+    auto* reader = formatManager.createReaderFor(file);
+    if (reader == nullptr || offlineRendering)
+        return reader;
+
+    const int samplesToBuffer = (int)(readAheadSeconds * reader->sampleRate);
+    return new HotCueReader(new ReadAheadReader(reader, *readAheadThread, samplesToBuffer, underrunCount));
+}
+
+std::unique_ptr<DeckTrack> PlayerAudio::createTrack(const juce::File& file)
+{
+    auto* reader = createReader(file);
+    if (reader == nullptr)
+        return nullptr;
+
+    auto track = std::make_unique<DeckTrack>();
+    track->file = file;
+    track->info = metadataCache->get(file);
+    track->sampleRate = reader->sampleRate;
+    track->hotCues = dynamic_cast<HotCueReader*>(reader);
+    track->readerSource = std::make_unique<juce::AudioFormatReaderSource>(reader, true);
+    track->loopSource = std::make_unique<RegionLoopSource>(track->readerSource.get());
+    return track;
+}
+
+void PlayerAudio::loadFileAsync()
+{
+    juce::FileChooser chooser("Select an audio file...", juce::File{}, "*.mp3;*.wav");
+
+    chooser.launchAsync(juce::FileBrowserComponent::openMode,
+        [this](const juce::FileChooser& fc)
+        {
+            auto file = fc.getResult();
+            if (file.existsAsFile())
+                loadFile(file);
+        });
+}
 
-        readerSource = std::make_unique<juce::AudioFormatReaderSource>(reader, true);
-        transportSource.setSource(readerSource.get(),
-            0,
-            nullptr,
-            reader->sampleRate);
 
-        // remember loaded file so GUI can build a thumbnail
-        currentFile = file;
+bool PlayerAudio::loadFileDirect(const juce::File& file)
+{
+    if (!file.existsAsFile())
+        return false;
 
-        transportSource.start();
+    // a background load still opening its file would replace this one
+    ++loadRequest;
+    loadPending = false;
 
-        // ensure resampler uses stored ratio
-        if (resamplingSource)
-            resamplingSource->setResamplingRatio(speedRatio);
+    if (auto track = createTrack(file))
+    {
+        installTrack(std::move(track));
+        return true;
     }
 
-    if (onFileLoaded)
-        onFileLoaded();
+    return false;
+}
+
+void PlayerAudio::loadFileInBackground(const juce::File& file, std::function<void(bool)> onDone)
+{
+    ++loadRequest;
+    loadPending = true;
+    decodeThreads->getJobPool().addJob(new LoadJob(*this, file, std::move(onDone), loadRequest), true);
+}
+
+void PlayerAudio::loadedTrackReady(std::unique_ptr<DeckTrack> track, int requestId, const std::function<void(bool)>& onDone)
+{
+    // another load or an unload came after this one
+    if (requestId != loadRequest)
+    {
+        decodeThreads->dispose(std::move(track));
+        return;
+    }
+
+    loadPending = false;
+    const bool loaded = track != nullptr;
+    if (loaded)
+        installTrack(std::move(track));
+
+    if (onDone)
+        onDone(loaded);
+}
+
+void PlayerAudio::installTrack(std::unique_ptr<DeckTrack> track)
+{
+    clearQueuedFile();
+    forgetHotCues();
+    setTrackInfo(track->info);
+
+    handover.prepareTrack(*track);
+
+    currentFile = track->file;
+
+    Command command;
+    command.type = Command::Type::loadTrack;
+    command.value = loadCrossfadeSeconds;
+    command.track = loadedTrack = track.release();
+    ++loadsSent;
+    looping = false;
+    sendCommand(command);
+
+    applyRegionToLoopSource();
+}
+
+
+void PlayerAudio::loadFile(const juce::File& file)
+{
+    if (!file.existsAsFile())
+        return;
+
+    loadFileInBackground(file, [this](bool loaded)
+        {
+            if (loaded)
+                start();
+
+            if (onFileLoaded)
+                onFileLoaded();
+        });
 
 }
 
 void PlayerAudio::start()
 {
-    if (transportSource.getLengthInSeconds() > 0.0)
-        transportSource.start();
+    if (getTotalLength() > 0)
+        sendCommand({ Command::Type::start });
 }
 
 void PlayerAudio::stop()
 {
-    transportSource.stop();
+    sendCommand({ Command::Type::stop });
 }
 
 void PlayerAudio::restart()
 {
-    transportSource.stop();
-    transportSource.setPosition(0.0);
-    transportSource.start();
+    stop();
+    setPosition(0);
+    start();
 }
 
-void PlayerAudio::setPosition(double seconds)
+void PlayerAudio::setPosition(juce::int64 samplePosition)
 {
-    transportSource.setPosition(seconds);
+    Command command;
+    command.type = Command::Type::setPosition;
+    command.position = juce::jmax((juce::int64)0, samplePosition);
+    sendCommand(command);
 }
 
-double PlayerAudio::getCurrentPosition() const
+juce::int64 PlayerAudio::getPosition() const
 {
-    return transportSource.getCurrentPosition();
+    return getTelemetry().positionSamples;
 }
 
-double PlayerAudio::getTotalLengthSeconds() const
+juce::int64 PlayerAudio::getTotalLength() const
 {
-    if (readerSource)
-    {
-        if (auto* r = readerSource->getAudioFormatReader())
-            return readerSource->getTotalLength() / r->sampleRate;
-    }
-    return 0.0;
+    if (loadedTrack != nullptr)
+        return loadedTrack->readerSource->getTotalLength();
+    return 0;
+}
+
+double PlayerAudio::getSampleRate() const noexcept
+{
+    return loadedTrack != nullptr ? loadedTrack->sampleRate : 0.0;
+}
+
+double PlayerAudio::samplesToSeconds(juce::int64 samples) const noexcept
+{
+    const double rate = getSampleRate();
+    return rate > 0.0 ? (double)samples / rate : 0.0;
+}
+
+juce::int64 PlayerAudio::secondsToSamples(double seconds) const noexcept
+{
+    return (juce::int64)std::llround(seconds * getSampleRate());
+}
+
+juce::AudioFormatReaderSource* PlayerAudio::getReaderSource() const noexcept
+{
+    if (loadedTrack != nullptr)
+        return loadedTrack->readerSource.get();
+    return nullptr;
 }
 
 void PlayerAudio::setGain(float g)
 {
-    transportSource.setGain(g);
+    gain = g;
 }
 
 float PlayerAudio::getGain() const
 {
-    return transportSource.getGain();
+    return gain;
+}
+
+void PlayerAudio::setPan(float newPan)
+{
+    pan = juce::jlimit(-1.0f, 1.0f, newPan);
+}
+
+float PlayerAudio::getPan() const
+{
+    return pan;
+}
+
+void PlayerAudio::setMuted(bool shouldBeMuted)
+{
+    muted = shouldBeMuted;
+}
+
+bool PlayerAudio::isMuted() const
+{
+    return muted;
 }
 
 bool PlayerAudio::isPlaying() const
 {
-    return transportSource.isPlaying();
+    return getTelemetry().playing;
 }
 
 void PlayerAudio::setLooping(bool shouldLoop)
 {
-    if (readerSource)
-        readerSource->setLooping(shouldLoop);
+    if (loadedTrack == nullptr)
+        return;
+
+    looping = shouldLoop;
+
+    Command command;
+    command.type = Command::Type::setLooping;
+    command.flag = shouldLoop;
+    sendCommand(command);
 }
 
 bool PlayerAudio::isLooping() const
 {
-    if (readerSource)
-        return readerSource->isLooping();
-    return false;
+    return looping;
 }
 
-void PlayerAudio::setSpeed(double ratio)
+void PlayerAudio::setKeepPitch(bool shouldKeepPitch)
 {
-    if (ratio < 0.01) ratio = 0.01;
-    if (ratio > 8.0) ratio = 8.0;
-    speedRatio = ratio;
-    if (resamplingSource)
-        resamplingSource->setResamplingRatio(speedRatio);
+    keepPitch = shouldKeepPitch;
+
+    Command command;
+    command.type = Command::Type::setKeepPitch;
+    command.flag = shouldKeepPitch;
+    sendCommand(command);
 }
 
-juce::AudioSource* PlayerAudio::getAudioSource() noexcept
+void PlayerAudio::setStretchQuality(TimeStretchSource::Quality newQuality)
 {
-    if (resamplingSource)
-        return resamplingSource.get();
+    stretchQuality = newQuality;
+    sendCommand({ Command::Type::setStretchQuality, (double)(int)newQuality });
+}
 
-    return &transportSource;
+void PlayerAudio::setHotCues(const std::vector<juce::int64>& cuePositions)
+{
+    hotCuePositions.clear();
+    ++hotCueRequest;
+
+    if (loadedTrack == nullptr)
+        return;
+
+    hotCuePositions = cuePositions;
+
+    // mapped and RAM-preloaded files are resident already
+    if (loadedTrack->hotCues == nullptr)
+        return;
+
+    const int snippetLength = (int)(juce::jmax(1.0, readAheadSeconds) * loadedTrack->sampleRate);
+    decodeThreads->getJobPool().addJob(new HotCueJob(*this, loadedTrack, hotCuePositions, snippetLength,
+        hotCueSnippets, hotCueRequest), true);
+}
+
+void PlayerAudio::forgetHotCues()
+{
+    // the snippets belong to the old file and a running job's bank is for the old track
+    hotCuePositions.clear();
+    hotCueSnippets.clear();
+    ++hotCueRequest;
+}
+
+void PlayerAudio::hotCueBankReady(std::unique_ptr<HotCueBank> bank, DeckTrack* track, int requestId)
+{
+    // the cues changed or another file was loaded while the job ran
+    if (bank == nullptr || requestId != hotCueRequest || track != loadedTrack)
+        return;
+
+    hotCueSnippets = bank->snippets;
+
+    Command command;
+    command.type = Command::Type::setHotCueBank;
+    command.track = track;
+    command.cueBank = bank.release();
+    sendCommand(command);
+}
+
+void PlayerAudio::jumpToHotCue(int index)
+{
+    if (index < 0 || index >= (int)hotCuePositions.size())
+        return;
+
+    Command command;
+    command.type = Command::Type::jumpToSample;
+    command.position = hotCuePositions[(size_t)index];
+    command.timestamp = juce::Time::getHighResolutionTicks();
+    sendCommand(command);
+}
+
+void PlayerAudio::setResampler(Resampler newResampler)
+{
+    resampler = newResampler;
+    sendCommand({ Command::Type::setResampler, (double)(int)newResampler });
+}
+
+void PlayerAudio::setSpeed(double ratio)
+{
+    speedRatio = juce::jlimit(minSpeed, maxSpeed, ratio);
+    sendCommand({ Command::Type::setSpeed, speedRatio });
 }
 
 // setRegionLooping function
-void PlayerAudio::setRegionLooping(bool shouldLoop, double start, double end)
+void PlayerAudio::setRegionLooping(bool shouldLoop, juce::int64 start, juce::int64 end)
 {
-    if (readerSource)
-        readerSource->setLooping(false); 
+    setLooping(false);
 
 	// store state
     regionLoopingActive = shouldLoop;
@@ -238,37 +1081,141 @@ void PlayerAudio::setRegionLooping(bool shouldLoop, double start, double end)
     {
         loopStart = juce::jmin(start, end);
         loopEnd = juce::jmax(start, end);
-
-		// make sure current position is within loop
-        if (transportSource.getCurrentPosition() < loopStart || transportSource.getCurrentPosition() >= loopEnd)
-            transportSource.setPosition(loopStart);
+        loopSampleRate = getSampleRate();
     }
     else
     {
 		// reset loop points
-        loopStart = 0.0;
-        loopEnd = 0.0;
+        loopStart = 0;
+        loopEnd = 0;
+        loopSampleRate = 0.0;
     }
+
+	// the loop stage wraps at the region end (and jumps in if playback is outside it)
+    applyRegionToLoopSource();
 }
 
-void PlayerAudio::updateMetadata(const juce::File& file)
+void PlayerAudio::applyRegionToLoopSource()
 {
-    if (!file.existsAsFile())
+    if (loadedTrack == nullptr)
         return;
 
-    TagLib::FileRef ref(file.getFullPathName().toRawUTF8());
-    if (!ref.isNull() && ref.tag())
+    // the points were set on a track at another rate: keep them at the same time
+    if (loopSampleRate > 0.0 && loopSampleRate != loadedTrack->sampleRate)
     {
-        trackTitle = juce::String::fromUTF8(ref.tag()->title().toCString(true));
-        trackArtist = juce::String::fromUTF8(ref.tag()->artist().toCString(true));
-        trackAlbum = juce::String::fromUTF8(ref.tag()->album().toCString(true));
+        const double scale = loadedTrack->sampleRate / loopSampleRate;
+        loopStart = (juce::int64)std::llround((double)loopStart * scale);
+        loopEnd = (juce::int64)std::llround((double)loopEnd * scale);
+        loopSampleRate = loadedTrack->sampleRate;
+    }
 
-        if (ref.audioProperties())
-        {
-            int totalSeconds = ref.audioProperties()->length();
-            trackDuration = juce::String(totalSeconds / 60) + ":" +
-                juce::String(totalSeconds % 60).paddedLeft('0', 2);
-        }
+    Command command;
+    command.type = Command::Type::setRegion;
+    command.flag = regionLoopingActive;
+    command.regionStart = loopStart;
+    command.regionEnd = loopEnd;
+    sendCommand(command);
+}
+
+void PlayerAudio::queueNextFile(const juce::File& file)
+{
+    clearQueuedFile();
+
+    if (file.existsAsFile() && loadedTrack != nullptr)
+        decodeThreads->getJobPool().addJob(new PreloadJob(*this, file, playlistCrossfade,
+            loadedTrack->file, loadedTrack->sampleRate, preloadRequest), true);
+}
+
+void PlayerAudio::clearQueuedFile()
+{
+    ++preloadRequest;
+    decodeThreads->dispose(handover.clearNextTrack());
+}
+
+void PlayerAudio::nextTrackReady(std::unique_ptr<DeckTrack> track, juce::int64 startPosition, juce::int64 mixPoint, int requestId)
+{
+    // a newer file was queued (or the deck was unloaded) while this one was opening
+    if (track == nullptr || requestId != preloadRequest || loadedTrack == nullptr)
+        return;
+
+    // a gapless switch happens inside the track queue without a new resampling ratio, so only switch
+    // seamlessly between matching files; otherwise hasStreamFinished() lets the GUI load the next file the normal way.
+    // A crossfade starts the file on the other voice with its own ratio.
+    if (playlistCrossfade.seconds <= 0.0 && loadedTrack->sampleRate != track->sampleRate)
+        return;
+
+    decodeThreads->dispose(handover.queueNextTrack(std::move(track), startPosition, mixPoint));
+}
+
+void PlayerAudio::setPlaylistCrossfade(const PlaylistCrossfade& newSettings)
+{
+    playlistCrossfade = newSettings;
+    playlistCrossfade.seconds = juce::jlimit(0.0, PlaylistCrossfade::maxSeconds, playlistCrossfade.seconds);
+
+    // a file queued for a crossfade may not be able to follow gaplessly
+    if (playlistCrossfade.seconds <= 0.0)
+        clearQueuedFile();
+
+    Command command;
+    command.type = Command::Type::setPlaylistCrossfade;
+    command.value = playlistCrossfade.seconds;
+    command.curve = playlistCrossfade.curve;
+    sendCommand(command);
+}
+
+bool PlayerAudio::handleTrackAdvance()
+{
+    collectRetiredTracks();
+
+    std::unique_ptr<DeckTrack> finished;
+    const bool advanced = handover.collectFinishedTrack(finished);
+    decodeThreads->dispose(std::move(finished));
+
+    if (!advanced)
+        return false;
+
+    // a file loaded since then replaces whatever the queue moved on to
+    if (loadsApplied.load() != loadsSent)
+        return false;
+
+    loadedTrack = handover.getLastStartedTrack();
+    forgetHotCues();
+    looping = false;
+
+    if (loadedTrack != nullptr)
+    {
+        currentFile = loadedTrack->file;
+
+        // parsed by the preload job, so there is no file access here
+        setTrackInfo(loadedTrack->info);
+    }
+
+    // keep the stored region looping settings on the new track
+    applyRegionToLoopSource();
+
+    if (onFileLoaded)
+        onFileLoaded();
+
+    return true;
+}
+
+void PlayerAudio::updateMetadata(const juce::File& file)
+{
+    setTrackInfo(metadataCache->get(file));
+}
+
+TrackInfo::Ptr PlayerAudio::getTrackInfo() const
+{
+    const juce::SpinLock::ScopedLockType sl(trackInfoLock);
+    return trackInfo;
+}
+
+void PlayerAudio::setTrackInfo(TrackInfo::Ptr info)
+{
+    // only the pointer changes hands under the lock; the old record is released after it
+    {
+        const juce::SpinLock::ScopedLockType sl(trackInfoLock);
+        std::swap(trackInfo, info);
     }
 }
 
@@ -277,14 +1224,21 @@ void PlayerAudio::updateMetadata(const juce::File& file)
 // New function to unload audio and clear metadata
 void PlayerAudio::unloadFile()
 {
-    transportSource.stop();
-    transportSource.setSource(nullptr);
-    readerSource.reset();
+    clearQueuedFile();
+    forgetHotCues();
+
+    // drops a background load that hasn't finished opening
+    ++loadRequest;
+    loadPending = false;
+
+    loadedTrack = nullptr;
+    ++loadsSent;
+    looping = false;
+
+    // fades out like a load, into a voice with no track
+    sendCommand({ Command::Type::unloadTrack, loadCrossfadeSeconds });
 
     // Clear metadata and current file
     currentFile = juce::File{};
-    trackTitle.clear();
-    trackArtist.clear();
-    trackAlbum.clear();
-    trackDuration.clear();
+    setTrackInfo(nullptr);
 }
\ No newline at end of file
@@ -1,24 +1,88 @@
 ﻿#pragma once
 #include <JuceHeader.h>
-#include <taglib/fileref.h>
-#include <taglib/tag.h>
+#include "DecodeThreadPool.h"
+#include "DeckVoice.h"
+#include "LockFreeQueue.h"
+#include "MappedPcmReader.h"
+#include "MetadataCache.h"
+#include "ReadAheadReader.h"
+#include "SampleCache.h"
+#include "TripleBuffer.h"
 
+// What a deck's audio thread last rendered, published once per block for the GUI
+struct DeckTelemetry
+{
+	static constexpr int maxChannels = 2;
+
+	juce::int64 positionSamples = 0;
+	juce::int64 lengthSamples = 0;
+	double sampleRate = 0.0; // of the playing file, 0 if none is loaded
+	float peak[maxChannels] = {};
+	float rms[maxChannels] = {};
+	bool playing = false;
+	bool streamFinished = false;
+	bool looping = false;
+	bool regionLooping = false;
+	bool keepPitch = false;
+	bool lastJumpResident = true; // whether the last hot cue jump played from memory
+	int underruns = 0;
+	float lastJumpLatencyMs = 0.0f; // from jumpToHotCue() until the first block from the cue was rendered
+	float stretchLoad = 0.0f; // time-stretch processing time over block duration
+
+	double getPositionSeconds() const noexcept { return sampleRate > 0.0 ? (double)positionSamples / sampleRate : 0.0; }
+	double getLengthSeconds() const noexcept { return sampleRate > 0.0 ? (double)lengthSamples / sampleRate : 0.0; }
+};
+
+// How a deck moves on from one playlist entry to the next
+struct PlaylistCrossfade
+{
+	enum class Curve { equalPower, linear, sCurve };
+
+	static constexpr double maxSeconds = 12.0;
 
-class PlayerAudio
+	double seconds = 0.0; // overlap, up to maxSeconds; 0 switches at the last sample without a gap
+	Curve curve = Curve::equalPower;
+
+	// start the overlap where the outgoing track falls below the threshold for good rather than
+	// at its last sample, and start the next track at its first sample above it
+	bool detectSilence = false;
+	float silenceThresholdDb = -50.0f;
+};
+
+// One deck. The controls below are called from the message thread; they don't touch the
+// source chain themselves but send a command through a lock-free queue, which the audio thread
+// drains at the start of its next block. The getters answer from what was last sent.
+class PlayerAudio : public juce::AudioSource
 {
 public:
 	PlayerAudio();
-	~PlayerAudio();
+	~PlayerAudio() override;
 
-	void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
-	void releaseResources();
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+	void releaseResources() override;
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
 
 	// Loading
 	void loadFileAsync(); // launches chooser (requires being called from GUI thread)
 	void loadFile(const juce::File& file);
 
-	// Direct loading without file chooser (for internal use)
-	void loadFileDirect(const juce::File& file);
+	// Direct loading without file chooser (for internal use); false if the file can't be opened.
+	// The file is opened and starts buffering before the audio thread swaps it in at a block
+	// boundary; if the deck is audible, the old track fades out over getLoadCrossfadeSeconds().
+	// Opening blocks the caller, so the GUI uses loadFileInBackground instead.
+	bool loadFileDirect(const juce::File& file);
+
+	// Opens the file on a background thread, then loads it like loadFileDirect on the message thread.
+	// onDone is called there with whether the file could be opened, unless another load or an unload
+	// has been asked for meanwhile, which drops this one.
+	void loadFileInBackground(const juce::File& file, std::function<void(bool loaded)> onDone = nullptr);
+
+	// Whether loadFileInBackground is still opening a file
+	bool isLoadPending() const noexcept { return loadPending; }
+
+	// Equal-power crossfade from the old track to one loaded while playing (0 cuts straight over)
+	void setLoadCrossfadeSeconds(double seconds) noexcept { loadCrossfadeSeconds = juce::jlimit(0.0, 1.0, seconds); }
+	double getLoadCrossfadeSeconds() const noexcept { return loadCrossfadeSeconds; }
 
 	
 
@@ -28,63 +92,291 @@ public:
 	void start();
 	void stop();
 	void restart();
-	void setPosition(double seconds);
-	double getCurrentPosition() const;
-	double getTotalLengthSeconds() const;
+
+	// Transport positions are sample frames of the loaded file, so seeks, cues and loop points land
+	// on exact samples; seconds are only for display and for input given in seconds
+	void setPosition(juce::int64 samplePosition);
+	juce::int64 getPosition() const;    // where the audio thread was at its last block
+	juce::int64 getTotalLength() const; // 0 if nothing is loaded
+	double getSampleRate() const noexcept; // of the loaded file, 0 if nothing is loaded
+	double samplesToSeconds(juce::int64 samples) const noexcept;
+	juce::int64 secondsToSamples(double seconds) const noexcept;
+
+	// Channel strip, read by the mix bus once per block and smoothed there
 	void setGain(float g);
 	float getGain() const;
+	void setPan(float newPan); // -1 = left, 0 = centre, 1 = right
+	float getPan() const;
+	void setMuted(bool shouldBeMuted);
+	bool isMuted() const;
+
 	bool isPlaying() const;
 	void setLooping(bool shouldLoop);
 	bool isLooping() const;
 
-	// Speed control (1.0 = normal) - optional if you kept earlier changes
+	// Speed control (1.0 = normal) - optional if you kept earlier changes.
+	// Limited to what the time-stretch can do, so the speed doesn't change when keep pitch is toggled.
+	static constexpr double minSpeed = TimeStretchSource::minTempo;
+	static constexpr double maxSpeed = TimeStretchSource::maxTempo;
 	void setSpeed(double ratio);
 	double getSpeed() const noexcept { return speedRatio; }
 
+	// Change speed without changing pitch (time-stretch) instead of like a turntable
+	void setKeepPitch(bool shouldKeepPitch);
+	bool getKeepPitch() const noexcept { return keepPitch; }
+	void setStretchQuality(TimeStretchSource::Quality newQuality);
+	TimeStretchSource::Quality getStretchQuality() const noexcept { return stretchQuality; }
+
+	// Which resampler does speed change and rate conversion: JUCE's, or the polyphase sinc one
+	using Resampler = DeckVoice::Resampler;
+	void setResampler(Resampler newResampler);
+	Resampler getResampler() const noexcept { return resampler; }
+
 	juce::AudioFormatManager* getFormatManager() noexcept { return &formatManager; }
-	juce::AudioFormatReaderSource* getReaderSource() const noexcept { return readerSource.get(); }
+	juce::AudioFormatReaderSource* getReaderSource() const noexcept;
 
 	// Returns the top-most AudioSource that should be queried for audio blocks.
-	juce::AudioSource* getAudioSource() noexcept;
+	juce::AudioSource* getAudioSource() noexcept { return this; }
 
 	// Expose the last loaded file so GUI can build a thumbnail
 	juce::File getCurrentFile() const noexcept { return currentFile; }
 
-	// kept for compatibility (returns the transport directly)
-	juce::AudioTransportSource* getTransportSource() noexcept { return &transportSource; }
-
 	// Region Looping Control
-	void setRegionLooping(bool shouldLoop, double start, double end);
+	void setRegionLooping(bool shouldLoop, juce::int64 start, juce::int64 end);
 	bool isRegionLooping() const noexcept { return regionLoopingActive; }
 
+	// The loop region in samples of the loaded track; rescaled when a track at another rate is loaded
+	juce::int64 getLoopRegionStart() const noexcept { return loopStart; }
+	juce::int64 getLoopRegionEnd() const noexcept { return loopEnd; }
+
+	// RAM preload, applied to the next file that gets loaded: the whole file is decoded into memory
+	// on a background thread, shared with any other deck playing it, and never read from disk again.
+	// Falls back to normal loading if the file doesn't fit in the SampleCache budget.
+	void setRamPreload(bool shouldPreload) noexcept { ramPreload = shouldPreload; }
+	bool isRamPreloadEnabled() const noexcept { return ramPreload; }
+	void setRamPreloadFormat(PreloadedAudio::SampleFormat format) noexcept { ramPreloadFormat = format; }
+	PreloadedAudio::SampleFormat getRamPreloadFormat() const noexcept { return ramPreloadFormat; }
+
+	// Offline rendering, applied to the next file that gets loaded: files are decoded on the rendering
+	// thread itself instead of ahead of it, so a block never comes out silent because the decoder was behind.
+	// Rendering then waits on the disk, so never use it with a device.
+	void setOfflineRendering(bool shouldRenderOffline) noexcept { offlineRendering = shouldRenderOffline; }
+	bool isRenderingOffline() const noexcept { return offlineRendering; }
+
+	// Read-ahead buffer size, applied to the next file that gets loaded
+	void setReadAheadSeconds(double seconds) noexcept { readAheadSeconds = juce::jmax(0.1, seconds); }
+	double getReadAheadSeconds() const noexcept { return readAheadSeconds; }
+
+	// Number of blocks the audio thread had to play silence because the decoder was behind
+	int getUnderrunCount() const noexcept { return underrunCount.load(std::memory_order_relaxed); }
+	void resetUnderrunCount() noexcept { underrunCount.store(0, std::memory_order_relaxed); }
+
 	
 	void updateMetadata(const juce::File& file);
 
 	void unloadFile(); 
 
+	// Hot cues of the loaded file, in samples. On streamed files the audio after each cue is
+	// decoded in the background and kept in memory; mapped and RAM-preloaded files are resident anyway.
+	void setHotCues(const std::vector<juce::int64>& cuePositions);
+
+	// Jumps to the exact sample of a cue at the start of the next block; see DeckTelemetry::lastJumpLatencyMs
+	void jumpToHotCue(int index);
+
+	// Gapless playlist playback: the file is opened and pre-rolled on a background thread
+	// and playback switches to it at the exact sample where the current file ends
+	void queueNextFile(const juce::File& file);
+	void clearQueuedFile();
+
+	// Call from the message thread; returns true if playback moved on to the queued file
+	bool handleTrackAdvance();
+
+	// Crossfade between playlist entries. Applies to the file queued next, so queue it again after changing this.
+	// Unlike a gapless switch, a crossfade can move on to a file with a different sample rate.
+	void setPlaylistCrossfade(const PlaylistCrossfade& newSettings);
+	const PlaylistCrossfade& getPlaylistCrossfade() const noexcept { return playlistCrossfade; }
 
-	// Metadata
-	juce::String trackTitle;
-	juce::String trackArtist;
-	juce::String trackAlbum;
+	// True once the current file has played to its end with nothing queued after it
+	bool hasStreamFinished() const noexcept { return getTelemetry().streamFinished; }
 
+	// Message thread: one consistent snapshot of the audio thread's state as of its last block
+	DeckTelemetry getTelemetry() const noexcept { return telemetry.read(); }
 
-	juce::String trackDuration;
+	// Audio thread: whether the blocks that follow are timed by stage (the mix bus turns this on while profiling),
+	// and the time the last block spent in each stage; the mix bus fills in the sum stage
+	void setStageTiming(bool shouldTime) noexcept;
+	const CallbackProfiler::StageTicks& getBlockStages() const noexcept { return blockStages; }
 
 
+	// Metadata of the loaded file (null if none); shared, never modified after creation.
+	// Any thread: the record is replaced as a whole, so a reader gets the old one or the new one.
+	TrackInfo::Ptr getTrackInfo() const;
 
 	std::function<void()> onFileLoaded;
 
 
 
 private:
+	class LoadJob;
+	class PreloadJob;
+	class HotCueJob;
+
+	// A change sent from the message thread, applied by the audio thread at the start of a block
+	struct Command
+	{
+		enum class Type { start, stop, setPosition, setSpeed, setKeepPitch, setStretchQuality, setResampler, setLooping, setRegion,
+			loadTrack, unloadTrack, jumpToSample, setHotCueBank, setPlaylistCrossfade };
+
+		Type type = Type::stop;
+		double value = 0.0; // speed ratio, stretch quality, resampler or crossfade seconds
+		PlaylistCrossfade::Curve curve = PlaylistCrossfade::Curve::equalPower; // setPlaylistCrossfade
+		juce::int64 position = 0; // setPosition and jumpToSample
+		juce::int64 regionStart = 0;
+		juce::int64 regionEnd = 0;
+		bool flag = false; // keep pitch, looping or region looping on/off
+		DeckTrack* track = nullptr; // loadTrack: owned by the command until it is applied
+		HotCueBank* cueBank = nullptr; // setHotCueBank: owned by the command until it is applied
+		juce::int64 timestamp = 0; // jumpToSample: high resolution ticks when it was sent
+	};
+
+	// hands the command to the audio thread, or applies it right here while no device is using this deck
+	void sendCommand(const Command& command);
+
+	// audio thread (or any thread holding commandLock while unprepared)
+	void renderBlock(const juce::AudioSourceChannelInfo& bufferToFill);
+	void applyPendingCommands() noexcept;
+	void applyCommand(const Command& command) noexcept;
+	void loadIntoIdleVoice(const Command& command) noexcept;
+	void startPlaylistCrossfade() noexcept;
+	void updateCanStartNext() noexcept;
+	void renderCrossfade(const juce::AudioSourceChannelInfo& bufferToFill) noexcept;
+	void finishCrossfade() noexcept;
+	void retireTrack(DeckTrack* track) noexcept;
+	void publishTelemetry(const juce::AudioSourceChannelInfo* renderedBlock) noexcept;
+
+	// message thread: hands the tracks the audio thread has let go of to the disposal thread
+	void collectRetiredTracks();
+
+	// reads from RAM in preload mode, maps uncompressed files, and wraps anything else so decoding
+	// happens on a read-ahead thread (except when rendering offline)
+	juce::AudioFormatReader* createReader(const juce::File& file);
+
+	// opens the file with its loop stage; safe to call from a background thread
+	std::unique_ptr<DeckTrack> createTrack(const juce::File& file);
+
+	// sends an opened track to the audio thread as the one to play
+	void installTrack(std::unique_ptr<DeckTrack> track);
+
+	// called on the message thread when a LoadJob has opened the file
+	void loadedTrackReady(std::unique_ptr<DeckTrack> track, int requestId, const std::function<void(bool)>& onDone);
+
+	// called on the message thread when a HotCueJob has decoded the snippets
+	void hotCueBankReady(std::unique_ptr<HotCueBank> bank, DeckTrack* track, int requestId);
+	void forgetHotCues();
+
+	// called on the message thread when a PreloadJob has opened the next file; startPosition and
+	// mixPoint are where the next file starts and where in the current one the crossfade begins
+	void nextTrackReady(std::unique_ptr<DeckTrack> track, juce::int64 startPosition, juce::int64 mixPoint, int requestId);
+
+	// publishes a record handed out by the MetadataCache (or null)
+	void setTrackInfo(TrackInfo::Ptr info);
+
+	// pushes the stored loop region to the loop stage, rescaled if the new track has another sample rate
+	void applyRegionToLoopSource();
+
 	juce::AudioFormatManager formatManager;
-	std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
-	juce::AudioTransportSource transportSource;
 
-	// Resampler -- may be null if not prepared
-	std::unique_ptr<juce::ResamplingAudioSource> resamplingSource;
+	// Tags and durations, shared with the GUI and kept on disk between sessions
+	juce::SharedResourcePointer<MetadataCache> metadataCache;
+	TrackInfo::Ptr trackInfo;
+	mutable juce::SpinLock trackInfoLock;
+
+	// Background decoding
+	juce::SharedResourcePointer<DecodeThreadPool> decodeThreads;
+	juce::TimeSliceThread* readAheadThread = nullptr;
+	double readAheadSeconds = 2.0;
+	std::atomic<bool> offlineRendering{ false };
+
+	// RAM preload; read by preload jobs too
+	juce::SharedResourcePointer<SampleCache> sampleCache;
+	std::atomic<bool> ramPreload{ false };
+	std::atomic<PreloadedAudio::SampleFormat> ramPreloadFormat{ PreloadedAudio::SampleFormat::float32 };
+	std::atomic<int> underrunCount{ 0 };
+
+	// Each load or playlist crossfade goes to the voice that isn't playing, so the old track can
+	// fade out on the other. The queued track is shared by both.
+	TrackHandover handover;
+	DeckVoice voices[2]{ DeckVoice(handover), DeckVoice(handover) };
+
+	// bumped whenever the queued file changes so stale preloads are thrown away
+	int preloadRequest = 0;
+
+	// Message thread -> audio thread. Every command retires at most two tracks or one cue bank and
+	// the message thread empties the retired queues before sending, so they can never fill up.
+	static constexpr int commandQueueSize = 256;
+	LockFreeQueue<Command, commandQueueSize> commands;
+	LockFreeQueue<DeckTrack*, commandQueueSize * 2> retiredTracks;
+	LockFreeQueue<HotCueBank*, commandQueueSize> retiredCueBanks;
+
+	// the audio thread only ever try-locks this; see sendCommand()
+	juce::SpinLock commandLock;
+	std::atomic<bool> prepared{ false };
+
+	// Channel strip settings
+	std::atomic<float> gain{ 1.0f };
+	std::atomic<float> pan{ 0.0f };
+	std::atomic<bool> muted{ false };
+
+	// What the message thread last sent
+	DeckTrack* loadedTrack = nullptr;
+	int loadsSent = 0;
+
+	// bumped by every load and unload so a background load that was overtaken is thrown away
+	int loadRequest = 0;
+	bool loadPending = false;
+	double loadCrossfadeSeconds = 0.02;
+	PlaylistCrossfade playlistCrossfade;
 	double speedRatio = 1.0;
+	bool keepPitch = false;
+	TimeStretchSource::Quality stretchQuality = TimeStretchSource::Quality::balanced;
+	Resampler resampler = Resampler::standard;
+	bool looping = false;
+	std::vector<juce::int64> hotCuePositions;
+	std::vector<HotCueBank::SnippetPtr> hotCueSnippets; // of the last bank sent, reused by the next
+	int hotCueRequest = 0;
+
+	// Audio thread state that every block reads: plain values only, so it fits one cache line
+	// and nothing in it owns memory. The message thread doesn't touch it while a device is running.
+	struct alignas(64) RealtimeState
+	{
+		bool playing = false;
+		bool streamFinished = false;
+		bool crossfadeIn = false; // the active voice started with the crossfade and follows its curve
+		bool lastJumpResident = true;
+		int activeVoice = 0;
+		int fadingVoice = -1; // playing out the previous track, or -1
+		int crossfadeLength = 0;
+		int crossfadePosition = 0;
+		float fadeGain = 0.0f;
+		float lastJumpLatencyMs = 0.0f;
+		PlaylistCrossfade::Curve crossfadeCurve = PlaylistCrossfade::Curve::equalPower;
+		PlaylistCrossfade::Curve playlistCurve = PlaylistCrossfade::Curve::equalPower;
+		double playlistCrossfadeSeconds = 0.0;
+		double deviceSampleRate = 0.0;
+		juce::int64 jumpRequestTicks = 0;
+	};
+
+	static_assert(std::is_trivially_copyable_v<RealtimeState>, "the real-time state must not own memory");
+	static_assert(sizeof(RealtimeState) == 64, "the real-time state should fill one cache line");
+
+	RealtimeState realtime;
+
+	// Audio thread buffers and results, sized in prepareToPlay
+	std::atomic<int> loadsApplied{ 0 };
+	TripleBuffer<DeckTelemetry> telemetry;
+	bool stageTiming = false;
+	CallbackProfiler::StageTicks blockStages;
+	juce::AudioBuffer<float> crossfadeBuffer;
 
 	std::unique_ptr<juce::FileChooser> fileChooser;
 
@@ -93,6 +385,9 @@ private:
 
 	// Region Looping Data
 	bool regionLoopingActive = false;
-	double loopStart = 0.0;
-	double loopEnd = 0.0;
+	juce::int64 loopStart = 0;
+	juce::int64 loopEnd = 0;
+	double loopSampleRate = 0.0; // of the track the loop points were set on
+
+	JUCE_DECLARE_WEAK_REFERENCEABLE(PlayerAudio)
 };
@@ -26,6 +26,40 @@ PlayerGUI::PlayerGUI()
     speedSlider.addListener(this);
     addAndMakeVisible(speedSlider);
 
+    // Keep pitch while changing speed, with the time-stretch quality next to it
+    keepPitchButton.addListener(this);
+    addAndMakeVisible(keepPitchButton);
+
+    stretchQualityBox.addItem("Low latency", (int)TimeStretchSource::Quality::lowLatency + 1);
+    stretchQualityBox.addItem("Balanced", (int)TimeStretchSource::Quality::balanced + 1);
+    stretchQualityBox.addItem("High quality", (int)TimeStretchSource::Quality::highQuality + 1);
+    stretchQualityBox.setSelectedId((int)TimeStretchSource::Quality::balanced + 1, juce::dontSendNotification);
+    stretchQualityBox.onChange = [this]
+    {
+        if (audio)
+            audio->setStretchQuality((TimeStretchSource::Quality)(stretchQualityBox.getSelectedId() - 1));
+    };
+    addAndMakeVisible(stretchQualityBox);
+
+    // Resampler used for speed change and sample-rate conversion
+    resamplerBox.addItem("Standard", (int)PlayerAudio::Resampler::standard + 1);
+    resamplerBox.addItem("Sinc", (int)PlayerAudio::Resampler::sinc + 1);
+    resamplerBox.setSelectedId((int)PlayerAudio::Resampler::standard + 1, juce::dontSendNotification);
+    resamplerBox.onChange = [this]
+    {
+        if (audio)
+            audio->setResampler((PlayerAudio::Resampler)(resamplerBox.getSelectedId() - 1));
+    };
+    addAndMakeVisible(resamplerBox);
+
+    // Balance slider next to the volume (double-click to centre)
+    panSlider.setRange(-1.0, 1.0, 0.01);
+    panSlider.setValue(0.0);
+    panSlider.setDoubleClickReturnValue(true, 0.0);
+    panSlider.setTextBoxStyle(juce::Slider::NoTextBox, true, 0, 0);
+    panSlider.addListener(this);
+    addAndMakeVisible(panSlider);
+
     // Progress Slider 
     progressSlider.setRange(0.0, 1.0);
     progressSlider.setSliderStyle(juce::Slider::LinearHorizontal);
@@ -42,6 +76,38 @@ PlayerGUI::PlayerGUI()
     repeatButton.addListener(this);
     addAndMakeVisible(repeatButton);
 
+    // Applies to the next file loaded on this deck, as does the sample format it is held in
+    ramPreloadButton.addListener(this);
+    addAndMakeVisible(ramPreloadButton);
+
+    ramPreloadFormatBox.addItem("32-bit float", (int)PreloadedAudio::SampleFormat::float32 + 1);
+    ramPreloadFormatBox.addItem("16-bit", (int)PreloadedAudio::SampleFormat::int16 + 1);
+    ramPreloadFormatBox.setSelectedId((int)PreloadedAudio::SampleFormat::float32 + 1, juce::dontSendNotification);
+    ramPreloadFormatBox.onChange = [this]
+    {
+        if (audio)
+            audio->setRamPreloadFormat((PreloadedAudio::SampleFormat)(ramPreloadFormatBox.getSelectedId() - 1));
+    };
+    addAndMakeVisible(ramPreloadFormatBox);
+
+    // Crossfade into the next playlist entry (0 s = gapless)
+    crossfadeSlider.setRange(0.0, PlaylistCrossfade::maxSeconds, 0.5);
+    crossfadeSlider.setValue(0.0, juce::dontSendNotification);
+    crossfadeSlider.setTextValueSuffix(" s fade");
+    crossfadeSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 70, 20);
+    crossfadeSlider.addListener(this);
+    addAndMakeVisible(crossfadeSlider);
+
+    crossfadeCurveBox.addItem("Equal power", (int)PlaylistCrossfade::Curve::equalPower + 1);
+    crossfadeCurveBox.addItem("Linear", (int)PlaylistCrossfade::Curve::linear + 1);
+    crossfadeCurveBox.addItem("S-curve", (int)PlaylistCrossfade::Curve::sCurve + 1);
+    crossfadeCurveBox.setSelectedId((int)PlaylistCrossfade::Curve::equalPower + 1, juce::dontSendNotification);
+    crossfadeCurveBox.onChange = [this] { applyPlaylistCrossfade(); };
+    addAndMakeVisible(crossfadeCurveBox);
+
+    skipSilenceButton.addListener(this);
+    addAndMakeVisible(skipSilenceButton);
+
     // pause icon
     juce::Path pausePath;
     pausePath.addRectangle(0.0f, 0.0f, 6.0f, 20.0f);
@@ -106,6 +172,59 @@ PlayerGUI::PlayerGUI()
     playlistBox.setOutlineThickness(1);
     playlistBox.setColour(juce::ListBox::outlineColourId, juce::Colours::grey);
 
+	// Import progress (only visible while files are being added)
+    importer.onTracksReady = [this](const std::vector<PlaylistImporter::ImportedTrack>& tracks)
+        {
+            const bool hadNextTrack = currentTrackIndex >= 0 && currentTrackIndex + 1 < (int)playlistFileObjects.size();
+
+            for (const auto& track : tracks)
+            {
+                playlistModel->trackDurations.push_back(track.playable ? formatTime(track.durationSeconds) : juce::String("--:--"));
+                playlistModel->trackPlayable.push_back(track.playable);
+                playlistFiles.add(track.displayName);
+                playlistFileObjects.push_back(track.file);
+            }
+
+            refreshPlaylistDisplay();
+
+			// get the first track ready as soon as its row is in
+            if (!importLoadedFirstTrack && audio != nullptr && !playlistFileObjects.empty())
+            {
+                importLoadedFirstTrack = true;
+                metadataLabel.setText(playlistFiles[0], juce::dontSendNotification);
+
+                currentTrackIndex = 0;
+
+				// the entry after it can only be queued once it is loaded
+                audio->loadFileInBackground(playlistFileObjects[0], [this](bool loaded)
+                    {
+                        if (loaded)
+                            queueNextPlaylistTrack();
+                    });
+            }
+            else if (!hadNextTrack)
+            {
+				// the entry after the current one is queued once, by the batch that brings it in;
+				// later batches only add rows further down
+                queueNextPlaylistTrack();
+            }
+        };
+    importer.onProgress = [this](int numDone, int numTotal)
+        {
+            importProgress = numTotal > 0 ? (double)numDone / (double)numTotal : 0.0;
+            importProgressBar.setTextToDisplay("Importing " + juce::String(numDone) + "/" + juce::String(numTotal));
+            importProgressBar.setVisible(true);
+            cancelImportButton.setVisible(true);
+        };
+    importer.onFinished = [this](bool)
+        {
+            importProgressBar.setVisible(false);
+            cancelImportButton.setVisible(false);
+        };
+    addChildComponent(importProgressBar);
+    cancelImportButton.addListener(this);
+    addChildComponent(cancelImportButton);
+
     markerModel = std::make_unique<MarkerModel>(*this);
     markerBox.setModel(markerModel.get());
     markerBox.setRowHeight(25);
@@ -115,6 +234,10 @@ PlayerGUI::PlayerGUI()
     markerBox.setColour(juce::ListBox::outlineColourId, juce::Colours::grey);
     addAndMakeVisible(markerBox);
 
+    // latency of the last marker jump, measured by the audio thread
+    cueJumpLabel.setJustificationType(juce::Justification::centredRight);
+    addAndMakeVisible(cueJumpLabel);
+
 
 
     for (auto* btn : { &ppButton , &toEndButton , &toStartButton , &fw10Button , &bw10Button })
@@ -130,6 +253,9 @@ PlayerGUI::~PlayerGUI()
     for (auto* btn : { &loadButton , &restartButton , &stopButton , &muteButton ,&loopRegionButton, &removeSelectedButton, &clearAllButton, &addMarkerButton , &clearMarkersButton })
         btn->removeListener(this);
 
+    importer.cancel();
+    cancelImportButton.removeListener(this);
+
     // remove Sleep Timer listener
     sleepTimerButton.removeListener(this);
     removeChildComponent(&sleepTimerButton);
@@ -139,12 +265,16 @@ PlayerGUI::~PlayerGUI()
 
     volumeSlider.removeListener(this);
     speedSlider.removeListener(this);
+    keepPitchButton.removeListener(this);
+    panSlider.removeListener(this);
     progressSlider.removeListener(this);
     repeatButton.removeListener(this);
+    ramPreloadButton.removeListener(this);
+    crossfadeSlider.removeListener(this);
+    skipSilenceButton.removeListener(this);
 
-    // reset thumbnail
-    thumbnail.reset();
-    thumbnailCache.reset();
+    // release the mapped peak file
+    peaks.reset();
 }
 
 void PlayerGUI::setAudio(PlayerAudio* audioPtr) noexcept
@@ -156,13 +286,25 @@ void PlayerGUI::setAudio(PlayerAudio* audioPtr) noexcept
     {
         audio->onFileLoaded = [this]()
             {
-                juce::MessageManager::callAsync([this]()
-                    {
-                        juce::File f = audio->getCurrentFile();
+                // the new track forgot the hot cues; the markers carry over at the same times
+                if (!markerPositions.empty())
+                {
+                    rescaleMarkersToTrack();
+                    audio->setHotCues(markerPositions);
+                    markerBox.repaint();
+                    repaint(waveformBounds);
+                }
+
+                // the loop region was rescaled by the deck
+                if (loopRegionActive)
+                    repaint(waveformBounds);
 
-                        juce::String title = audio->trackTitle.trim();
-                        juce::String artist = audio->trackArtist.trim();
-                        juce::String album = audio->trackAlbum.trim();
+                // the record is immutable, so the label shows this load's tags even if another load follows
+                juce::MessageManager::callAsync([this, info = audio->getTrackInfo(), f = audio->getCurrentFile()]()
+                    {
+                        juce::String title = info != nullptr ? info->title.trim() : juce::String();
+                        juce::String artist = info != nullptr ? info->artist.trim() : juce::String();
+                        juce::String album = info != nullptr ? info->album.trim() : juce::String();
 
                         bool hasMetadata = !title.isEmpty() || !artist.isEmpty() || !album.isEmpty();
 
@@ -182,22 +324,81 @@ void PlayerGUI::setAudio(PlayerAudio* audioPtr) noexcept
 
 
 
-    // create thumbnail+cache now that we can access a format manager
-    if (audio != nullptr && audio->getFormatManager() != nullptr)
+    // if audio already has a file, show its waveform now
+    if (audio != nullptr)
     {
-        thumbnailCache = std::make_unique<juce::AudioThumbnailCache>(5);
-        thumbnail = std::make_unique<juce::AudioThumbnail>(512, *audio->getFormatManager(), *thumbnailCache);
-
-        // if audio already has a file, set it now
         juce::File f = audio->getCurrentFile();
         if (f.existsAsFile())
         {
-            thumbnail->setSource(new juce::FileInputSource(f));
             lastLoadedFile = f;
+            loadPeaks(f);
         }
     }
 }
 
+void PlayerGUI::loadPeaks(const juce::File& f)
+{
+    const juce::File peakFile = WaveformPeaks::getPeakFileFor(f);
+    peaks = WaveformPeaks::open(peakFile);
+
+    // first time this file is shown (or its peak file is damaged): build it in the background
+    if (peaks == nullptr && !peakFilesFailed.contains(peakFile))
+    {
+        if (!peakFilesInProgress.contains(peakFile))
+            peakFile.deleteFile();
+
+        generatePeaks(f);
+    }
+
+    invalidateWaveform();
+}
+
+void PlayerGUI::generatePeaks(const juce::File& f)
+{
+    const juce::File peakFile = WaveformPeaks::getPeakFileFor(f);
+    if (peakFile.existsAsFile() || peakFilesInProgress.contains(peakFile) || peakFilesFailed.contains(peakFile))
+        return;
+
+    peakFilesInProgress.add(peakFile);
+
+    juce::Component::SafePointer<PlayerGUI> safe(this);
+    decodeThreads->getJobPool().addJob([safe, f, peakFile]()
+        {
+            juce::AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+
+            const bool generated = WaveformPeaks::generate(f, peakFile, formatManager, []()
+                {
+                    auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+                    return job != nullptr && job->shouldExit();
+                });
+
+            juce::MessageManager::callAsync([safe, f, peakFile, generated]()
+                {
+                    if (auto* gui = safe.getComponent())
+                    {
+                        gui->peakFilesInProgress.removeFirstMatchingValue(peakFile);
+
+                        // an unreadable file, an unwritable cache or a cancelled job would only fail again
+                        if (!generated)
+                            gui->peakFilesFailed.addIfNotAlreadyThere(peakFile);
+
+                        // still showing this file: map the result, without starting another job if it isn't usable
+                        if (f == gui->lastLoadedFile)
+                        {
+                            gui->peaks = WaveformPeaks::open(peakFile);
+                            if (gui->peaks == nullptr)
+                                gui->peakFilesFailed.addIfNotAlreadyThere(peakFile);
+
+                            gui->invalidateWaveform();
+                        }
+                    }
+                });
+
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+}
+
 
 
 
@@ -215,34 +416,31 @@ void PlayerGUI::paint(juce::Graphics& g)
     g.drawFittedText("Simple Audio Player", getLocalBounds().reduced(10), juce::Justification::centredTop, 1);
 
     // Draw waveform if available
-    if (thumbnail)
+    if (audio != nullptr)
     {
-        // background for waveform
-        g.setColour(juce::Colours::black.withAlpha(0.6f));
-        g.fillRect(waveformBounds);
+        const juce::int64 length = audio->getTotalLength();
+        const double total = audio->samplesToSeconds(length);
+
+		// the waveform itself only changes on resize or track change, so it's drawn from a cached image
+        if (waveformImageDirty || total != waveformImageTotal)
+            renderWaveformImage(total);
 
-        // outline
-        g.setColour(juce::Colours::grey);
-        g.drawRect(waveformBounds);
+        g.drawImage(waveformImage, waveformBounds.toFloat());
 
-        double total = audio ? audio->getTotalLengthSeconds() : 0.0;
-        if (total > 0.0)
+        if (length > 0)
         {
-			// draw waveform
-            thumbnail->drawChannel(g, waveformBounds.reduced(4), 0.0, total, 0, 1.0f);
+			// x of a sample position on the waveform
+            auto getX = [&](juce::int64 position)
+                {
+                    double pos = juce::jlimit(0.0, 1.0, (double)position / (double)length);
+                    return waveformBounds.getX() + static_cast<int>(pos * (double)waveformBounds.getWidth());
+                };
 
             // Draw Loop Region Markers
             if (loopRegionActive)
             {
-				// get loop start and end in seconds
-                auto getX = [&](double seconds)
-                    {
-                        double pos = juce::jlimit(0.0, 1.0, seconds / total);
-                        return waveformBounds.getX() + static_cast<int>(pos * (double)waveformBounds.getWidth());
-                    };
-
-                int startX = getX(loopStartSeconds);
-                int endX = getX(loopEndSeconds);
+                int startX = getX(audio->getLoopRegionStart());
+                int endX = getX(audio->getLoopRegionEnd());
 
 				// draw filled rectangle for loop area
                 juce::Rectangle<int> loopArea(startX, waveformBounds.getY(), endX - startX, waveformBounds.getHeight());
@@ -255,36 +453,25 @@ void PlayerGUI::paint(juce::Graphics& g)
                 g.drawLine((float)endX, (float)waveformBounds.getY(), (float)endX, (float)waveformBounds.getBottom(), 2.0f);   // خط النهاية
             }
 
-            if (total > 0.0 && !markerTimes.empty())
+            if (!markerPositions.empty())
             {
                 g.setColour(juce::Colours::green);
 
-                auto getX = [&](double seconds)
-                    {
-                        double pos = juce::jlimit(0.0, 1.0, seconds / total);
-                        return waveformBounds.getX() + static_cast<int>(pos * (double)waveformBounds.getWidth());
-                    };
-
-                for (double markerTime : markerTimes)
+                for (juce::int64 markerPosition : markerPositions)
                 {
 					// calculate x position
-                    int markerX = getX(markerTime);
+                    int markerX = getX(markerPosition);
 					// draw marker line
                     g.drawLine((float)markerX, (float)waveformBounds.getY(), (float)markerX, (float)waveformBounds.getBottom(), 2.0f);
                 }
             }
 
-            // draw current position pointer
-            double current = audio ? audio->getCurrentPosition() : 0.0;
-            double pos = juce::jlimit(0.0, 1.0, (total > 0.0) ? (current / total) : 0.0);
-            int x = waveformBounds.getX() + static_cast<int>(pos * (double)waveformBounds.getWidth());
-            g.setColour(juce::Colours::deepskyblue);
-            g.drawLine((float)x, (float)waveformBounds.getY(), (float)x, (float)waveformBounds.getBottom(), 2.0f);
-        }
-        else
-        {
-            g.setColour(juce::Colours::darkgrey);
-            g.drawText("Waveform", waveformBounds, juce::Justification::centred);
+            // draw current position pointer (where updatePlayhead last put it)
+            if (playheadX >= 0)
+            {
+                g.setColour(juce::Colours::deepskyblue);
+                g.drawLine((float)playheadX, (float)waveformBounds.getY(), (float)playheadX, (float)waveformBounds.getBottom(), 2.0f);
+            }
         }
     }
     // Draw playlist headers
@@ -300,6 +487,86 @@ void PlayerGUI::paint(juce::Graphics& g)
     g.drawText("Markers", playlistArea.getX() + 5, headerY+160, 200, 20, juce::Justification::left);
 }
 
+void PlayerGUI::renderWaveformImage(double total)
+{
+    waveformImageDirty = false;
+    waveformImageTotal = total;
+
+    if (waveformBounds.isEmpty())
+    {
+        waveformImage = {};
+        return;
+    }
+
+	// render at the display's scale so it stays sharp on high-DPI screens
+    const float scale = juce::Component::getApproximateScaleFactorForComponent(this);
+    waveformImage = juce::Image(juce::Image::ARGB,
+        juce::roundToInt(waveformBounds.getWidth() * scale),
+        juce::roundToInt(waveformBounds.getHeight() * scale), true);
+
+    juce::Graphics g(waveformImage);
+    g.addTransform(juce::AffineTransform::scale(scale));
+
+    const auto area = waveformBounds.withZeroOrigin();
+
+    // background for waveform
+    g.setColour(juce::Colours::black.withAlpha(0.6f));
+    g.fillRect(area);
+
+    // outline
+    g.setColour(juce::Colours::grey);
+    g.drawRect(area);
+
+    if (total > 0.0)
+    {
+		// draw waveform
+        if (peaks != nullptr)
+            peaks->drawChannel(g, area.reduced(4), 0.0, total, 0, 1.0f);
+    }
+    else
+    {
+        g.setColour(juce::Colours::darkgrey);
+        g.drawText("Waveform", area, juce::Justification::centred);
+    }
+}
+
+void PlayerGUI::invalidateWaveform()
+{
+    waveformImageDirty = true;
+    repaint(waveformBounds);
+}
+
+int PlayerGUI::getPlayheadX() const
+{
+    if (audio == nullptr)
+        return -1;
+
+    const auto telemetry = audio->getTelemetry();
+    if (telemetry.lengthSamples <= 0)
+        return -1;
+
+    double pos = juce::jlimit(0.0, 1.0, (double)telemetry.positionSamples / (double)telemetry.lengthSamples);
+    return waveformBounds.getX() + static_cast<int>(pos * (double)waveformBounds.getWidth());
+}
+
+void PlayerGUI::updatePlayhead()
+{
+    const int x = getPlayheadX();
+    if (x == playheadX)
+        return;
+
+	// only the strips under the old and the new pointer need to be redrawn
+    auto strip = [this](int stripX) { return juce::Rectangle<int>(stripX - 2, waveformBounds.getY(), 5, waveformBounds.getHeight()); };
+
+    if (playheadX >= 0)
+        repaint(strip(playheadX));
+
+    playheadX = x;
+
+    if (playheadX >= 0)
+        repaint(strip(playheadX));
+}
+
 void PlayerGUI::resized()
 {
     auto area = getLocalBounds().reduced(50);
@@ -319,15 +586,21 @@ void PlayerGUI::resized()
     buttonArea.removeFromLeft(spacing);
     sleepTimerButton.setBounds(buttonArea.removeFromLeft(buttonWidth));
     area.removeFromTop(20);
-    volumeSlider.setBounds(area.removeFromTop(40));
+    auto volumeRow = area.removeFromTop(40);
+    panSlider.setBounds(volumeRow.removeFromRight(120));
+    volumeSlider.setBounds(volumeRow);
 
     // Place the new Loop Region button 
     buttonArea.removeFromLeft(spacing);
     loopRegionButton.setBounds(buttonArea.removeFromLeft(buttonWidth + 20)); // <--- إضافة
     area.removeFromTop(10);
 
-    // Place speed slider under volume slider
-    speedSlider.setBounds(area.removeFromTop(30));
+    // Place speed slider under volume slider, pitch options on its right
+    auto speedRow = area.removeFromTop(30);
+    resamplerBox.setBounds(speedRow.removeFromRight(90).reduced(0, 3));
+    stretchQualityBox.setBounds(speedRow.removeFromRight(110).reduced(0, 3));
+    keepPitchButton.setBounds(speedRow.removeFromRight(100));
+    speedSlider.setBounds(speedRow);
 
 
     // Place progress slider and lables and repeat button
@@ -335,6 +608,8 @@ void PlayerGUI::resized()
     currentTimeLabel.setBounds(20, 240, 60, 20);
     totalTimeLabel.setBounds(getWidth() - 65, 240, 60, 20);
     repeatButton.setBounds(getWidth() - 135, 230, buttonWidth, 40);
+    ramPreloadButton.setBounds(getWidth() - 265, 230, 125, 40);
+    ramPreloadFormatBox.setBounds(getWidth() - 365, 238, 95, 24);
 
 
     // Place control button
@@ -356,6 +631,7 @@ void PlayerGUI::resized()
     int wfHeight = 120;
     int wfY = yPos + smallButtonHeight + 20;
     waveformBounds = { 20, wfY, getWidth() - 40, wfHeight-50 };
+    waveformImageDirty = true;
 
     // Place metadata label below waveform
     metadataLabel.setBounds(20, wfY + wfHeight - 50, getWidth() - 40, 30);
@@ -364,9 +640,18 @@ void PlayerGUI::resized()
     int playlistButtonY = metadataLabel.getBottom() + 10;
     int playlistButtonWidth = 120;
     int playlistSpacing = 10;
+    importProgressBar.setBounds(20, playlistButtonY, 140, 30);
+    cancelImportButton.setBounds(165, playlistButtonY, 60, 30);
     removeSelectedButton.setBounds(235, playlistButtonY, playlistButtonWidth, 30);
     clearAllButton.setBounds(235 + playlistButtonWidth + playlistSpacing, playlistButtonY, playlistButtonWidth, 30);
 
+    // Crossfade controls fill the rest of the row
+    auto crossfadeRow = juce::Rectangle<int>(clearAllButton.getRight() + playlistSpacing, playlistButtonY, 0, 30)
+        .withRight(juce::jmax(clearAllButton.getRight() + playlistSpacing, getWidth() - 20));
+    skipSilenceButton.setBounds(crossfadeRow.removeFromRight(110));
+    crossfadeCurveBox.setBounds(crossfadeRow.removeFromRight(110).reduced(0, 3));
+    crossfadeSlider.setBounds(crossfadeRow);
+
     // Place playlist box at the bottom, below the new buttons
     playlistBox.setBounds(20, playlistButtonY + 40, getWidth() - 40, 120);
 
@@ -377,6 +662,8 @@ void PlayerGUI::resized()
 	// Place clear markers button below marker box
     addMarkerButton.setBounds(-25 + (playlistButtonWidth + playlistSpacing) * 2, playlistButtonY +165, playlistButtonWidth, 30);
 	clearMarkersButton.setBounds(105 + (playlistButtonWidth + playlistSpacing) * 2, playlistButtonY +165, playlistButtonWidth, 30);
+    cueJumpLabel.setBounds(clearMarkersButton.getRight() + 10, playlistButtonY + 165,
+        juce::jmax(0, getWidth() - 20 - (clearMarkersButton.getRight() + 10)), 30);
 }
 
 juce::String PlayerGUI::formatTime(double seconds)
@@ -386,6 +673,11 @@ juce::String PlayerGUI::formatTime(double seconds)
     return juce::String(mins) + ":" + (secs < 10 ? "0" : "") + juce::String(secs);
 }
 
+juce::String PlayerGUI::formatPosition(juce::int64 samples)
+{
+    return formatTime(audio != nullptr ? audio->samplesToSeconds(samples) : 0.0);
+}
+
 void PlayerGUI::buttonClicked(juce::Button* button)
 {
     if (!audio)
@@ -402,49 +694,23 @@ void PlayerGUI::buttonClicked(juce::Button* button)
 
                 clearMarkers();
 
-                for (auto& f : results)
-                {
-					// Get duration 
-                    juce::String durationString = "0:00";
-                    if (auto* formatManager = audio->getFormatManager())
-                    {
-                        std::unique_ptr<juce::AudioFormatReader> reader(formatManager->createReaderFor(f));
-                        if (reader) 
-                        {
-                            double durationSeconds = (double)reader->lengthInSamples / reader->sampleRate;
-                            durationString = formatTime(durationSeconds);
-                        }
-                    }
-
-                    playlistModel->trackDurations.push_back(durationString);
-
-                    TagLib::FileRef ref(f.getFullPathName().toRawUTF8());
-                    juce::String displayName;
-
-                    if (!ref.isNull() && ref.tag() && ref.tag()->title().length() > 0)
-                        displayName = juce::String::fromUTF8(ref.tag()->title().toCString(true));
-                    else
-                        displayName = f.getFileNameWithoutExtension();
-
-                    playlistFiles.add(displayName);
-                    playlistFileObjects.push_back(f);
-                }
-
-                refreshPlaylistDisplay();
-
-                if (!playlistFileObjects.empty())
-                {
-                    audio->loadFileDirect(playlistFileObjects[0]);
-                    metadataLabel.setText(playlistFiles[0], juce::dontSendNotification);
-                }
+				// tags and durations are read on the worker pool; rows arrive in onTracksReady
+                importLoadedFirstTrack = false;
+                importer.start(results);
             });
     }
 
  
+    if (button == &cancelImportButton)
+    {
+        importer.cancel();
+    }
+
     if (button == &removeSelectedButton)
     {
        
 		audio->unloadFile(); 
+        currentTrackIndex = -1;
        
         clearMarkers();
 
@@ -464,6 +730,9 @@ void PlayerGUI::buttonClicked(juce::Button* button)
             if (selectedRow < playlistModel->trackTitles.size())
                 playlistModel->trackTitles.erase(playlistModel->trackTitles.begin() + selectedRow);
 
+            if (selectedRow < playlistModel->trackPlayable.size())
+                playlistModel->trackPlayable.erase(playlistModel->trackPlayable.begin() + selectedRow);
+
             // Refresh the display
             refreshPlaylistDisplay();
             playlistBox.deselectRow(selectedRow); // Deselect row
@@ -481,7 +750,9 @@ void PlayerGUI::buttonClicked(juce::Button* button)
     if (button == &clearAllButton)
     {
 
+        importer.cancel();
         audio->unloadFile();
+        currentTrackIndex = -1;
 		clearMarkers();
 
         // Clear all data sources
@@ -489,6 +760,7 @@ void PlayerGUI::buttonClicked(juce::Button* button)
         playlistFiles.clear();
         playlistModel->trackDurations.clear();
         playlistModel->trackTitles.clear();
+        playlistModel->trackPlayable.clear();
 
         // Refresh the display
         refreshPlaylistDisplay();
@@ -512,14 +784,14 @@ void PlayerGUI::buttonClicked(juce::Button* button)
     if (button == &stopButton)
     {
         audio->stop();
-        audio->setPosition(0.0);
+        audio->setPosition(0);
         ppButton.setImages(playIcon.get());
     }
 
     if (button == &muteButton)
     {
-        bool isMuted = audio->getGain() == 0.0f;
-        audio->setGain(isMuted ? (float)volumeSlider.getValue() : 0.0f);
+        bool isMuted = audio->isMuted();
+        audio->setMuted(!isMuted);
         if (isMuted) {
             muteButton.setButtonText("Mute");
             muteButton.removeColour(juce::TextButton::buttonColourId);
@@ -530,6 +802,15 @@ void PlayerGUI::buttonClicked(juce::Button* button)
         }
     }
 
+    if (button == &ramPreloadButton)
+        audio->setRamPreload(ramPreloadButton.getToggleState());
+
+    if (button == &skipSilenceButton)
+        applyPlaylistCrossfade();
+
+    if (button == &keepPitchButton)
+        audio->setKeepPitch(keepPitchButton.getToggleState());
+
     if (button == &repeatButton)
     {
         bool shouldLooping = repeatButton.getToggleState();
@@ -556,7 +837,7 @@ void PlayerGUI::buttonClicked(juce::Button* button)
     {
         if (audio->getReaderSource() != nullptr)
         {
-            audio->setPosition(0.0);
+            audio->setPosition(0);
             audio->start();
         }
     }
@@ -565,10 +846,10 @@ void PlayerGUI::buttonClicked(juce::Button* button)
     {
         if (audio->getReaderSource() != nullptr)
         {
-            double total = audio->getTotalLengthSeconds();
-            audio->setPosition(total);
+            const juce::int64 length = audio->getTotalLength();
+            audio->setPosition(length);
             progressSlider.setValue(1.0);
-            currentTimeLabel.setText(formatTime(total), juce::dontSendNotification);
+            currentTimeLabel.setText(formatPosition(length), juce::dontSendNotification);
         }
     }
 
@@ -576,9 +857,7 @@ void PlayerGUI::buttonClicked(juce::Button* button)
     {
         if (audio->getReaderSource() != nullptr)
         {
-            double current = audio->getCurrentPosition();
-            double newPos = current + 10.0;
-            audio->setPosition(newPos);
+            audio->setPosition(audio->getPosition() + audio->secondsToSamples(10.0));
         }
     }
 
@@ -586,11 +865,8 @@ void PlayerGUI::buttonClicked(juce::Button* button)
     {
         if (audio->getReaderSource() != nullptr)
         {
-            double current = audio->getCurrentPosition();
-            double newPos = current - 10.0;
-            if (newPos < 0.0)
-                newPos = 0.0;
-            audio->setPosition(newPos);
+            const juce::int64 newPos = audio->getPosition() - audio->secondsToSamples(10.0);
+            audio->setPosition(juce::jmax((juce::int64)0, newPos));
         }
     }
 
@@ -643,8 +919,6 @@ void PlayerGUI::buttonClicked(juce::Button* button)
         {
 			// activate loop region setting
             loopRegionActive = true;
-            loopStartSeconds = 0.0;
-            loopEndSeconds = audio->getTotalLengthSeconds();
 
 			// ask user to set start point
             loopRegionButton.setButtonText("Set Start (Click Waveform)");
@@ -652,7 +926,7 @@ void PlayerGUI::buttonClicked(juce::Button* button)
             loopRegionButton.setColour(juce::TextButton::buttonColourId, juce::Colours::orange);
 
 			// update state to wait for user to click waveform
-            audio->setRegionLooping(true, loopStartSeconds, loopEndSeconds);
+            audio->setRegionLooping(true, 0, audio->getTotalLength());
         }
         else
         {
@@ -665,26 +939,32 @@ void PlayerGUI::buttonClicked(juce::Button* button)
             loopRegionButton.removeColour(juce::TextButton::buttonColourId);
 
 			// disable region looping
-            audio->setRegionLooping(false, 0.0, 0.0);
+            audio->setRegionLooping(false, 0, 0);
         }
+
+		// to show or hide the loop overlay
+        repaint(waveformBounds);
     }
 
     if (button == &addMarkerButton)
     {
         if (audio && audio->getReaderSource() != nullptr)
         {
-            double currentTime = audio->getCurrentPosition();
-
-			// add marker at current time
-            markerTimes.push_back(currentTime);
+			// add marker at the exact sample the deck is at
+            rescaleMarkersToTrack();
+            markerPositions.push_back(audio->getPosition());
 
 			// arrange markers in order
-            std::sort(markerTimes.begin(), markerTimes.end());
+            std::sort(markerPositions.begin(), markerPositions.end());
 
 			// erase duplicates within 0.01 seconds
-            markerTimes.erase(std::unique(markerTimes.begin(), markerTimes.end(),
-                [](double a, double b) { return std::abs(a - b) < 0.01; }),
-                markerTimes.end());
+            const juce::int64 minDistance = audio->secondsToSamples(0.01);
+            markerPositions.erase(std::unique(markerPositions.begin(), markerPositions.end(),
+                [minDistance](juce::int64 a, juce::int64 b) { return std::abs(a - b) < minDistance; }),
+                markerPositions.end());
+
+			// markers are the deck's hot cues
+            audio->setHotCues(markerPositions);
 
 			// update marker list display
             markerBox.updateContent();
@@ -705,10 +985,24 @@ void PlayerGUI::sliderValueChanged(juce::Slider* slider)
     if (!audio) return;
 
     if (slider == &volumeSlider) {
+        // moving the volume unmutes, as it always has
+        audio->setMuted(false);
         muteButton.setButtonText("Mute");
         muteButton.removeColour(juce::TextButton::buttonColourId);
     }
 
+    if (slider == &panSlider)
+    {
+        audio->setPan((float)panSlider.getValue());
+        return;
+    }
+
+    if (slider == &crossfadeSlider)
+    {
+        applyPlaylistCrossfade();
+        return;
+    }
+
     // Speed slider handling (new)
     if (slider == &speedSlider)
     {
@@ -719,15 +1013,12 @@ void PlayerGUI::sliderValueChanged(juce::Slider* slider)
 
     if (slider == &progressSlider && audio->getReaderSource() != nullptr)
     {
-        double total = audio->getTotalLengthSeconds();
-        double newPos = progressSlider.getValue() * total;
+        const juce::int64 length = audio->getTotalLength();
+        juce::int64 newPos = (juce::int64)(progressSlider.getValue() * (double)length);
 
-        // If region looping is active, clamp newPos to [loopStartSeconds, loopEndSeconds]
+        // If region looping is active, clamp newPos to [loopStart, loopEnd]
         if (loopRegionActive)
-        {
-            if (newPos < loopStartSeconds) newPos = loopStartSeconds;
-            if (newPos > loopEndSeconds) newPos = loopEndSeconds;
-        }
+            newPos = juce::jlimit(audio->getLoopRegionStart(), audio->getLoopRegionEnd(), newPos);
 
         audio->setPosition(newPos);
 
@@ -737,46 +1028,60 @@ void PlayerGUI::sliderValueChanged(juce::Slider* slider)
 
 void PlayerGUI::timerCallback()
 {
-    // If a new file was loaded, set the thumbnail source
+    // If a new file was loaded, map its peak file
     if (audio != nullptr)
     {
         juce::File f = audio->getCurrentFile();
-        if (f != lastLoadedFile && f.existsAsFile() && thumbnail)
+        if (f != lastLoadedFile && f.existsAsFile())
         {
-            thumbnail->setSource(new juce::FileInputSource(f));
             lastLoadedFile = f;
+            loadPeaks(f);
         }
-    }
 
-    if (audio->isPlaying() && audio->getReaderSource() != nullptr)
-    {
-        double current = audio->getCurrentPosition();
-        double total = audio->getTotalLengthSeconds();
-
-        if (total > 0.0)
+        // automatic advance through the playlist
+        if (audio->handleTrackAdvance())
         {
-            // Use dontSendNotification to avoid triggering sliderValueChanged, which would call setPosition()
-            progressSlider.setValue(current / total, juce::dontSendNotification);
-            currentTimeLabel.setText(formatTime(current), juce::dontSendNotification);
-            totalTimeLabel.setText(formatTime(total), juce::dontSendNotification);
+            // the audio thread already switched to the queued entry without a gap
+            ++currentTrackIndex;
+            clearMarkers();
+            playlistBox.selectRow(currentTrackIndex);
+            queueNextPlaylistTrack();
         }
-        if (loopRegionActive && current >= loopEndSeconds)
+        else if (audio->hasStreamFinished() && !audio->isLoadPending() && currentTrackIndex >= 0
+            && currentTrackIndex + 1 < (int)playlistFileObjects.size())
         {
-            // loop back to start of region
-            audio->setPosition(loopStartSeconds);
-            // make sure playback continues (in case it was paused/stopped)
-            if (!audio->isPlaying())
-                audio->start();
+            // the next entry couldn't be queued seamlessly (e.g. different sample rate)
+            ++currentTrackIndex;
+            clearMarkers();
+            playlistBox.selectRow(currentTrackIndex);
+            audio->loadFileInBackground(playlistFileObjects[currentTrackIndex], [this](bool loaded)
+                {
+                    if (audio->onFileLoaded) audio->onFileLoaded();
+                    if (loaded) audio->start();
+                    queueNextPlaylistTrack();
+                });
         }
-        else if (loopRegionActive && current < loopStartSeconds)
+    }
+
+    // everything the audio thread reports comes from one snapshot of its last block
+    const auto telemetry = audio != nullptr ? audio->getTelemetry() : DeckTelemetry();
+
+    if (telemetry.playing && telemetry.sampleRate > 0.0)
+    {
+        if (telemetry.lengthSamples > 0)
         {
-            // if playback is before loop start, jump to loop start
-            audio->setPosition(loopStartSeconds);
-            if (!audio->isPlaying())
-                audio->start();
+            // Use dontSendNotification to avoid triggering sliderValueChanged, which would call setPosition()
+            progressSlider.setValue((double)telemetry.positionSamples / (double)telemetry.lengthSamples, juce::dontSendNotification);
+            currentTimeLabel.setText(formatTime(telemetry.getPositionSeconds()), juce::dontSendNotification);
+            totalTimeLabel.setText(formatTime(telemetry.getLengthSeconds()), juce::dontSendNotification);
         }
+        // region looping is handled inside the audio render path (see RegionLoopSource)
     }
 
+    if (telemetry.lastJumpLatencyMs > 0.0f)
+        cueJumpLabel.setText("Cue jump " + juce::String(telemetry.lastJumpLatencyMs, 1) + " ms"
+            + (telemetry.lastJumpResident ? "" : " (from disk)"), juce::dontSendNotification);
+
     // Sleep timer update and enforcement
     if (sleepTimerActive)
     {
@@ -792,9 +1097,6 @@ void PlayerGUI::timerCallback()
             sleepTimerButton.setButtonText("Sleep: " + formatTime(remainingSeconds));
         }
     }
-
-    // request repaint so pointer moves smoothly
-    repaint(waveformBounds);
 }
 
 void PlayerGUI::mouseDown(const juce::MouseEvent& event)
@@ -803,45 +1105,48 @@ void PlayerGUI::mouseDown(const juce::MouseEvent& event)
 
     if (waveformBounds.contains(event.getPosition()))
     {
-        double total = audio->getTotalLengthSeconds();
-        if (total <= 0.0) return;
+        const juce::int64 length = audio->getTotalLength();
+        if (length <= 0) return;
 
         double localX = event.x - waveformBounds.getX();
         double proportion = juce::jlimit(0.0, 1.0, localX / (double)waveformBounds.getWidth());
-        double clickedPos = proportion * total; 
+        const juce::int64 clickedPos = (juce::int64)(proportion * (double)length);
 
         // Logic to set loop points
         if (settingLoopPoint != LoopPointState::None)
         {
+            juce::int64 loopStart = audio->getLoopRegionStart();
+            juce::int64 loopEnd = audio->getLoopRegionEnd();
+
             if (settingLoopPoint == LoopPointState::SettingStart)
             {
-                loopStartSeconds = clickedPos;
+                loopStart = clickedPos;
                 settingLoopPoint = LoopPointState::SettingEnd;
                 loopRegionButton.setButtonText("Set End (Click Waveform)");
 
                 // set a temporary end point if start > end
-                if (loopStartSeconds > loopEndSeconds)
-                    loopEndSeconds = total;
+                if (loopStart > loopEnd)
+                    loopEnd = length;
             }
             else if (settingLoopPoint == LoopPointState::SettingEnd)
             {
-                loopEndSeconds = clickedPos;
+                loopEnd = clickedPos;
                 settingLoopPoint = LoopPointState::None; 
 
 				// make sure start is less than end
-                if (loopStartSeconds > loopEndSeconds)
-                    std::swap(loopStartSeconds, loopEndSeconds);
+                if (loopStart > loopEnd)
+                    std::swap(loopStart, loopEnd);
 
 				// set button appearance to show active loop region
-                loopRegionButton.setButtonText("Looping (" + formatTime(loopStartSeconds) + " to " + formatTime(loopEndSeconds) + ")");
+                loopRegionButton.setButtonText("Looping (" + formatPosition(loopStart) + " to " + formatPosition(loopEnd) + ")");
                 loopRegionButton.setColour(juce::TextButton::buttonColourId, juce::Colours::green);
             }
 
 			// update audio region looping
-            audio->setRegionLooping(true, loopStartSeconds, loopEndSeconds);
+            audio->setRegionLooping(true, loopStart, loopEnd);
 
 			// move playback position to loop start
-            audio->setPosition(loopStartSeconds);
+            audio->setPosition(loopStart);
         }
         else
         {
@@ -856,9 +1161,28 @@ void PlayerGUI::mouseDown(const juce::MouseEvent& event)
 }
 
 
+void PlayerGUI::rescaleMarkersToTrack()
+{
+    const double sampleRate = audio != nullptr ? audio->getSampleRate() : 0.0;
+    if (sampleRate <= 0.0)
+        return;
+
+    if (markerSampleRate > 0.0 && markerSampleRate != sampleRate)
+    {
+        const double scale = sampleRate / markerSampleRate;
+        for (auto& position : markerPositions)
+            position = (juce::int64)std::llround((double)position * scale);
+    }
+
+    markerSampleRate = sampleRate;
+}
+
 void PlayerGUI::clearMarkers()
 {
-    markerTimes.clear();
+    markerPositions.clear();
+    if (audio)
+        audio->setHotCues(markerPositions);
+    cueJumpLabel.setText({}, juce::dontSendNotification);
     markerBox.updateContent();
     markerBox.repaint();
     repaint(waveformBounds); 
@@ -867,7 +1191,7 @@ void PlayerGUI::clearMarkers()
 // Marker Model methods
 int PlayerGUI::MarkerModel::getNumRows()
 {
-    return gui.markerTimes.size();
+    return (int)gui.markerPositions.size();
 }
 
 void PlayerGUI::MarkerModel::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected)
@@ -877,12 +1201,11 @@ void PlayerGUI::MarkerModel::paintListBoxItem(int rowNumber, juce::Graphics& g,
     else
         g.fillAll(juce::Colours::darkgrey);
 
-    if (rowNumber < 0 || rowNumber >= gui.markerTimes.size())
+    if (rowNumber < 0 || rowNumber >= (int)gui.markerPositions.size())
         return;
 
 	// time formatting
-    double time = gui.markerTimes[rowNumber];
-    juce::String timeString = gui.formatTime(time);
+    juce::String timeString = gui.formatPosition(gui.markerPositions[(size_t)rowNumber]);
     juce::String markerText = "Marker " + juce::String(rowNumber + 1) + " (" + timeString + ")";
 
     g.setColour(juce::Colours::white);
@@ -891,16 +1214,13 @@ void PlayerGUI::MarkerModel::paintListBoxItem(int rowNumber, juce::Graphics& g,
 
 void PlayerGUI::MarkerModel::listBoxItemClicked(int row, const juce::MouseEvent&)
 {
-    if (row < 0 || row >= gui.markerTimes.size())
+    if (row < 0 || row >= (int)gui.markerPositions.size())
         return;
 
     if (gui.audio)
     {
-		// seek to marker time
-        double time = gui.markerTimes[row];
-
-		// jump to marker time
-        gui.audio->setPosition(time);
+		// jump to the marker's exact sample, played from memory
+        gui.audio->jumpToHotCue(row);
 
 		// make sure playback starts
         if (!gui.audio->isPlaying())
@@ -918,6 +1238,22 @@ void PlayerGUI::refreshPlaylistDisplay()
     playlistBox.repaint();
 }
 
+void PlayerGUI::queueNextPlaylistTrack()
+{
+    if (!audio) return;
+
+    const int nextIndex = currentTrackIndex + 1;
+    if (currentTrackIndex >= 0 && nextIndex < (int)playlistFileObjects.size())
+    {
+        audio->queueNextFile(playlistFileObjects[nextIndex]);
+
+        // have its waveform ready too by the time it starts
+        generatePeaks(playlistFileObjects[nextIndex]);
+    }
+    else
+        audio->clearQueuedFile();
+}
+
 void PlayerGUI::PlaylistModel::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected)
 {
     if (rowIsSelected)
@@ -930,8 +1266,12 @@ void PlayerGUI::PlaylistModel::paintListBoxItem(int rowNumber, juce::Graphics& g
 
     juce::String title = rowNumber < (int)trackTitles.size() ? trackTitles[rowNumber] : gui.playlistFiles[rowNumber];
     juce::String duration = rowNumber < (int)trackDurations.size() ? trackDurations[rowNumber] : "";
+    const bool playable = rowNumber >= (int)trackPlayable.size() || trackPlayable[(size_t)rowNumber];
 
-    g.setColour(juce::Colours::white);
+    if (!playable)
+        title += " (can't play)";
+
+    g.setColour(playable ? juce::Colours::white : juce::Colours::grey);
     g.drawText(title, 10, 0, width / 2, height, juce::Justification::centredLeft);
     g.drawText(duration, width / 2, 0, width / 2 - 10, height, juce::Justification::centredRight);
 }
@@ -944,6 +1284,7 @@ void PlayerGUI::setPlaylist(const std::vector<juce::File>& files, const juce::St
     playlistFiles.clear();
     playlistModel->trackDurations.clear();
     playlistModel->trackTitles.clear();
+    playlistModel->trackPlayable.clear();
 
     if (files.empty())
     {
@@ -951,26 +1292,20 @@ void PlayerGUI::setPlaylist(const std::vector<juce::File>& files, const juce::St
         return;
     }
 
-    // add new files
+    // add new files; ones that are gone or can't be decoded are kept but marked, so they aren't lost silently
     for (int i = 0; i < files.size(); ++i)
     {
         const auto& f = files[i];
-        if (f.existsAsFile())
-        {
-            juce::String duration = (i < durations.size()) ? durations[i] : "0:00";
-            playlistModel->trackDurations.push_back(duration);
-       
-            TagLib::FileRef ref(f.getFullPathName().toRawUTF8());
-            juce::String displayName;
+        const auto info = metadataCache->get(f);
+        const bool playable = info->isValid();
 
-            if (!ref.isNull() && ref.tag() && ref.tag()->title().length() > 0)
-                displayName = juce::String::fromUTF8(ref.tag()->title().toCString(true));
-            else
-                displayName = f.getFileNameWithoutExtension();
+        juce::String duration = !playable ? juce::String("--:--")
+            : (i < durations.size()) ? durations[i] : formatTime(info->durationSeconds);
+        playlistModel->trackDurations.push_back(duration);
+        playlistModel->trackPlayable.push_back(playable);
 
-            playlistFiles.add(displayName);
-            playlistFileObjects.push_back(f);
-        }
+        playlistFiles.add(info->getDisplayName());
+        playlistFileObjects.push_back(f);
     }
 
     // update display
@@ -981,10 +1316,35 @@ void PlayerGUI::updateControlsFromAudio()
 {
     if (!audio) return;
 
-	// update speed slider
+	// update speed and balance sliders
     speedSlider.setValue(audio->getSpeed(), juce::dontSendNotification);
+    panSlider.setValue(audio->getPan(), juce::dontSendNotification);
+    keepPitchButton.setToggleState(audio->getKeepPitch(), juce::dontSendNotification);
+    stretchQualityBox.setSelectedId((int)audio->getStretchQuality() + 1, juce::dontSendNotification);
+    resamplerBox.setSelectedId((int)audio->getResampler() + 1, juce::dontSendNotification);
 
 	// update repeat button
     repeatButton.setToggleState(audio->isLooping(), juce::dontSendNotification);
+    ramPreloadButton.setToggleState(audio->isRamPreloadEnabled(), juce::dontSendNotification);
+    ramPreloadFormatBox.setSelectedId((int)audio->getRamPreloadFormat() + 1, juce::dontSendNotification);
+
+    const auto& crossfade = audio->getPlaylistCrossfade();
+    crossfadeSlider.setValue(crossfade.seconds, juce::dontSendNotification);
+    crossfadeCurveBox.setSelectedId((int)crossfade.curve + 1, juce::dontSendNotification);
+    skipSilenceButton.setToggleState(crossfade.detectSilence, juce::dontSendNotification);
+}
+
+void PlayerGUI::applyPlaylistCrossfade()
+{
+    if (!audio) return;
+
+    PlaylistCrossfade crossfade = audio->getPlaylistCrossfade();
+    crossfade.seconds = crossfadeSlider.getValue();
+    crossfade.curve = (PlaylistCrossfade::Curve)(crossfadeCurveBox.getSelectedId() - 1);
+    crossfade.detectSilence = skipSilenceButton.getToggleState();
+    audio->setPlaylistCrossfade(crossfade);
+
+    // the mix point of the queued entry depends on these
+    queueNextPlaylistTrack();
 }
 
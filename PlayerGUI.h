@@ -1,6 +1,8 @@
 ﻿#pragma once
 #include <JuceHeader.h>
 #include "PlayerAudio.h"
+#include "PlaylistImporter.h"
+#include "WaveformPeaks.h"
 
 class PlayerGUI : public juce::Component,
     public juce::Button::Listener,
@@ -11,7 +13,7 @@ public:
     PlayerGUI();
     ~PlayerGUI() override;
 
-    // setAudio now implemented in cpp so we can build the thumbnail when audio is provided
+    // setAudio now implemented in cpp so we can show the waveform when audio is provided
     void setAudio(PlayerAudio* audioPtr) noexcept;
 
     void paint(juce::Graphics& g) override;
@@ -33,8 +35,14 @@ public:
 
     void refreshPlaylistDisplay();
 
+	// pre-roll the playlist entry after the current one so it follows without a gap (or crossfades in)
+    void queueNextPlaylistTrack();
+
     void clearMarkers();
 
+	// keeps the markers at the same times when a track at another sample rate is loaded
+    void rescaleMarkersToTrack();
+
     
 
 
@@ -48,6 +56,7 @@ public:
     }
 
     juce::String formatTime(double seconds);
+    juce::String formatPosition(juce::int64 samples); // formatTime() of a position on the deck
 
     // expose some internals if needed (same names as original)
     juce::TextButton loadButton{ "Load Files" };
@@ -67,6 +76,7 @@ public:
     juce::TextButton addMarkerButton{ "Add Marker" };
     juce::TextButton clearMarkersButton{ "clear Markers" };
 	juce::Label MarkerBoxLabel;
+    juce::Label cueJumpLabel;
     
 
     std::unique_ptr<juce::DrawablePath> playIcon; // Icon for play
@@ -84,6 +94,19 @@ public:
 
     // speed control
     juce::Slider speedSlider; 
+    juce::ToggleButton keepPitchButton{ "Keep pitch" };
+    juce::ComboBox stretchQualityBox;
+    juce::ComboBox resamplerBox;
+    juce::ToggleButton ramPreloadButton{ "Preload to RAM" };
+    juce::ComboBox ramPreloadFormatBox;
+
+    // crossfade between playlist entries
+    juce::Slider crossfadeSlider;
+    juce::ComboBox crossfadeCurveBox;
+    juce::ToggleButton skipSilenceButton{ "Skip silence" };
+
+    // balance (-1 left .. 1 right)
+    juce::Slider panSlider;
 
     // Sleep Timer button 
     juce::TextButton sleepTimerButton{ "Sleep Timer" };
@@ -96,6 +119,9 @@ public:
         std::vector<juce::String> trackTitles;
         std::vector<juce::String> trackDurations;
 
+        // false for files that are missing or can't be decoded; they stay listed, greyed out
+        std::vector<bool> trackPlayable;
+
         PlaylistModel(PlayerGUI& owner) : gui(owner) {}
 
         int getNumRows() override { return gui.playlistFiles.size(); }
@@ -107,7 +133,7 @@ public:
             if (row >= 0 && row < gui.playlistFileObjects.size())
             {
 
-                gui.markerTimes.clear();
+                gui.markerPositions.clear();
                 gui.markerBox.updateContent();
                 gui.markerBox.repaint();
                 gui.repaint(gui.waveformBounds);
@@ -115,36 +141,42 @@ public:
 				// select the file
                 juce::File f = gui.playlistFileObjects[row];
 
-				// load the selected file
-                gui.audio->loadFileDirect(f);
-
-				// update metadata display
-                TagLib::FileRef ref(f.getFullPathName().toRawUTF8());
-                juce::String displayTitle;
-
-                if (!ref.isNull() && ref.tag())
-                {
-                    auto* tag = ref.tag();
-                    juce::String title = juce::String::fromUTF8(tag->title().toCString(true));
-                    juce::String artist = juce::String::fromUTF8(tag->artist().toCString(true));
-                    juce::String album = juce::String::fromUTF8(tag->album().toCString(true));
-
-					// merge metadata into display string
-                    if (title.isNotEmpty()) displayTitle = title;
-                    if (artist.isNotEmpty()) displayTitle += " - " + artist;
-                    if (album.isNotEmpty()) displayTitle += " | " + album;
-                }
-
-				// if no metadata, use filename
-                if (displayTitle.isEmpty())
-                    displayTitle = f.getFileNameWithoutExtension();
-
-				// display the title
-                gui.metadataLabel.setText(displayTitle, juce::dontSendNotification);
-
-				// start playback
-                gui.audio->start();
-                gui.ppButton.setImages(gui.pauseButtonIcon.get());
+                gui.currentTrackIndex = row;
+
+				// load the selected file; it is opened in the background
+                gui.audio->loadFileInBackground(f, [&g = gui, f](bool loaded)
+                    {
+                        if (!loaded)
+                        {
+                            g.metadataLabel.setText("Can't play " + f.getFileName(), juce::dontSendNotification);
+                            return;
+                        }
+
+						// update metadata display (the deck already has the parsed record)
+                        juce::String displayTitle;
+
+                        if (auto info = g.audio->getTrackInfo())
+                        {
+							// merge metadata into display string
+                            if (info->title.isNotEmpty()) displayTitle = info->title;
+                            if (info->artist.isNotEmpty()) displayTitle += " - " + info->artist;
+                            if (info->album.isNotEmpty()) displayTitle += " | " + info->album;
+                        }
+
+						// if no metadata, use filename
+                        if (displayTitle.isEmpty())
+                            displayTitle = f.getFileNameWithoutExtension();
+
+						// display the title
+                        g.metadataLabel.setText(displayTitle, juce::dontSendNotification);
+
+						// start playback
+                        g.audio->start();
+                        g.ppButton.setImages(g.pauseButtonIcon.get());
+
+						// get the next entry ready in the background
+                        g.queueNextPlaylistTrack();
+                    });
             }
         }
        
@@ -181,23 +213,43 @@ public:
 private:
     PlayerAudio* audio = nullptr;
 
-    // Waveform thumbnail + cache
-    std::unique_ptr<juce::AudioThumbnailCache> thumbnailCache;
-    std::unique_ptr<juce::AudioThumbnail> thumbnail;
+    // Waveform peaks (memory-mapped from the peak file cache)
+    std::unique_ptr<WaveformPeaks> peaks;
+    juce::Array<juce::File> peakFilesInProgress;
+    juce::Array<juce::File> peakFilesFailed; // not generated again this session
+    juce::SharedResourcePointer<DecodeThreadPool> decodeThreads;
     juce::File lastLoadedFile;
+
+	// sends the crossfade controls to the deck and queues the next entry again with them
+    void applyPlaylistCrossfade();
+
+	// maps the file's peaks if they were generated before, otherwise starts generating them
+    void loadPeaks(const juce::File& f);
+    void generatePeaks(const juce::File& f);
+
+	// Static part of the waveform, only redrawn on resize or when the track changes
+    juce::Image waveformImage;
+    bool waveformImageDirty = true;
+    double waveformImageTotal = 0.0;
+    void renderWaveformImage(double total);
+    void invalidateWaveform();
+
+	// Playhead, moved once per display frame and only repainted when it moves a pixel
+    int playheadX = -1;
+    int getPlayheadX() const;
+    void updatePlayhead();
     juce::Rectangle<int> waveformBounds;
 
     juce::ListBox markerBox;
-    std::vector<double> markerTimes;
+    std::vector<juce::int64> markerPositions; // in samples of the loaded file, sorted
+    double markerSampleRate = 0.0; // of the track the markers were set on
 
     // Sleep timer state
     bool sleepTimerActive = false;
     juce::Time sleepTimerEnd;
 
-    // Region Loop State
+    // Region Loop State; the points themselves are kept by the deck, see PlayerAudio::getLoopRegionStart()
     bool loopRegionActive = false;
-    double loopStartSeconds = 0.0;
-    double loopEndSeconds = 0.0;
 
 	// mode for setting loop points
     enum class LoopPointState { None, SettingStart, SettingEnd };
@@ -211,12 +263,28 @@ private:
     juce::StringArray playlistFiles;
     std::vector<juce::File> playlistFileObjects;
 
+	// playlist entry that is loaded in the deck (-1 if none)
+    int currentTrackIndex = -1;
+
     
     std::unique_ptr<juce::FileChooser> fileChooser;
 
+	// Tags and durations shared with PlayerAudio
+    juce::SharedResourcePointer<MetadataCache> metadataCache;
+
+	// Background playlist import
+    PlaylistImporter importer;
+    bool importLoadedFirstTrack = false;
+    double importProgress = 0.0;
+    juce::ProgressBar importProgressBar{ importProgress };
+    juce::TextButton cancelImportButton{ "Cancel" };
+
 
     
 
 
+	// called in sync with the display refresh
+    juce::VBlankAttachment vBlankAttachment{ this, [this] { updatePlayhead(); } };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PlayerGUI)
 };
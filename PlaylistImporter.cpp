@@ -0,0 +1,146 @@
+#include "PlaylistImporter.h"
+
+// Reads one file's title and duration. Holds nothing of the importer but a weak reference,
+// so the importer can go away while the job is still running.
+class PlaylistImporter::ImportJob : public juce::ThreadPoolJob
+{
+public:
+    ImportJob(PlaylistImporter& ownerToUse, int batchIdToUse, int indexToUse, const juce::File& fileToRead,
+        std::shared_ptr<std::atomic<bool>> cancelFlag)
+        : juce::ThreadPoolJob("Import " + fileToRead.getFileName()),
+          owner(&ownerToUse), weakOwner(&ownerToUse), batchId(batchIdToUse), index(indexToUse),
+          file(fileToRead), cancelled(std::move(cancelFlag))
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        if (cancelled->load() || shouldExit())
+            return jobHasFinished;
+
+        const auto info = metadataCache->get(file);
+
+        ImportedTrack track;
+        track.file = file;
+        track.durationSeconds = info->durationSeconds;
+        track.displayName = info->getDisplayName();
+        track.playable = info->isValid();
+
+        if (cancelled->load())
+            return jobHasFinished;
+
+        juce::MessageManager::callAsync([weak = weakOwner, id = batchId, i = index, track]()
+            {
+                if (auto* importer = weak.get())
+                    importer->trackImported(id, i, track);
+            });
+
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const PlaylistImporter* importer) const noexcept { return owner == importer; }
+
+private:
+    const PlaylistImporter* owner; // only compared, never followed
+    juce::WeakReference<PlaylistImporter> weakOwner;
+    juce::SharedResourcePointer<MetadataCache> metadataCache;
+    int batchId;
+    int index;
+    juce::File file;
+    std::shared_ptr<std::atomic<bool>> cancelled;
+};
+
+PlaylistImporter::~PlaylistImporter()
+{
+    if (cancelled)
+        cancelled->store(true);
+
+    // jobs that haven't started are dropped; running ones finish on their own, see ImportJob
+    removeOwnJobs(0);
+}
+
+void PlaylistImporter::start(const juce::Array<juce::File>& files)
+{
+    if (isRunning())
+        cancel();
+
+    ++batch;
+    cancelled = std::make_shared<std::atomic<bool>>(false);
+    results.clear();
+    results.resize((size_t)files.size());
+    numFiles = files.size();
+    numDone = 0;
+    nextToDeliver = 0;
+
+    if (numFiles == 0)
+    {
+        if (onFinished) onFinished(false);
+        return;
+    }
+
+    if (onProgress) onProgress(0, numFiles);
+
+    for (int i = 0; i < files.size(); ++i)
+        decodeThreads->getJobPool().addJob(new ImportJob(*this, batch, i, files[i], cancelled), true);
+}
+
+void PlaylistImporter::cancel()
+{
+    if (!isRunning())
+        return;
+
+    cancelled->store(true);
+    removeOwnJobs(0);
+
+    ++batch;
+    results.clear();
+    numFiles = 0;
+
+    if (onFinished) onFinished(true);
+}
+
+void PlaylistImporter::trackImported(int batchId, int index, ImportedTrack track)
+{
+    if (batchId != batch || index < 0 || index >= (int)results.size())
+        return;
+
+    results[(size_t)index] = std::make_unique<ImportedTrack>(std::move(track));
+    ++numDone;
+
+    // hand out every row whose predecessors are all done, so rows keep their playlist order
+    std::vector<ImportedTrack> ready;
+    while (nextToDeliver < numFiles && results[(size_t)nextToDeliver] != nullptr)
+    {
+        ready.push_back(std::move(*results[(size_t)nextToDeliver]));
+        results[(size_t)nextToDeliver].reset();
+        ++nextToDeliver;
+    }
+
+    if (!ready.empty() && onTracksReady)
+        onTracksReady(ready);
+
+    if (onProgress) onProgress(numDone, numFiles);
+
+    if (numDone == numFiles)
+    {
+        results.clear();
+        numFiles = 0;
+        if (onFinished) onFinished(false);
+    }
+}
+
+void PlaylistImporter::removeOwnJobs(int timeoutMs)
+{
+    struct OwnJobs : public juce::ThreadPool::JobSelector
+    {
+        const PlaylistImporter* importer;
+        explicit OwnJobs(const PlaylistImporter* i) : importer(i) {}
+        bool isJobSuitable(juce::ThreadPoolJob* job) override
+        {
+            auto* importJob = dynamic_cast<ImportJob*>(job);
+            return importJob != nullptr && importJob->belongsTo(importer);
+        }
+    } ownJobs(this);
+
+    decodeThreads->getJobPool().removeAllJobs(true, timeoutMs, &ownJobs);
+}
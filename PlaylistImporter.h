@@ -0,0 +1,58 @@
+#pragma once
+#include <JuceHeader.h>
+#include "DecodeThreadPool.h"
+#include "MetadataCache.h"
+
+// Looks up the title and duration of every file being added to a playlist on the shared job pool.
+// Results come back on the message thread in playlist order, a few rows at a time,
+// as soon as every file before them is done.
+class PlaylistImporter
+{
+public:
+	struct ImportedTrack
+	{
+		juce::File file;
+		juce::String displayName;
+		double durationSeconds = 0.0;
+		bool playable = false; // false if the file is missing or can't be decoded
+	};
+
+	PlaylistImporter() = default;
+	~PlaylistImporter();
+
+	// Starts importing the files (cancels an import that is still running)
+	void start(const juce::Array<juce::File>& files);
+
+	// Stops handing out rows; jobs that haven't started yet are dropped
+	void cancel();
+
+	bool isRunning() const noexcept { return numFiles > 0; }
+
+	// Message thread callbacks
+	std::function<void(const std::vector<ImportedTrack>&)> onTracksReady;
+	std::function<void(int numDone, int numTotal)> onProgress;
+	std::function<void(bool wasCancelled)> onFinished;
+
+private:
+	class ImportJob;
+
+	// called on the message thread when a job is done with its file
+	void trackImported(int batchId, int index, ImportedTrack track);
+
+	// drops the jobs of this importer that haven't started, and waits up to timeoutMs for running ones
+	void removeOwnJobs(int timeoutMs);
+
+	juce::SharedResourcePointer<DecodeThreadPool> decodeThreads;
+	juce::SharedResourcePointer<MetadataCache> metadataCache;
+
+	// the current import; anything arriving with an older batch id is ignored
+	int batch = 0;
+	std::shared_ptr<std::atomic<bool>> cancelled;
+	std::vector<std::unique_ptr<ImportedTrack>> results;
+	int numFiles = 0;
+	int numDone = 0;
+	int nextToDeliver = 0;
+
+	JUCE_DECLARE_WEAK_REFERENCEABLE(PlaylistImporter)
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PlaylistImporter)
+};
@@ -0,0 +1,51 @@
+#include "ProfilerOverlay.h"
+
+ProfilerOverlay::ProfilerOverlay(CallbackProfiler& profilerToShow)
+    : profiler(profilerToShow)
+{
+    setInterceptsMouseClicks(false, false);
+    timerCallback();
+    startTimer(250);
+}
+
+ProfilerOverlay::~ProfilerOverlay()
+{
+    stopTimer();
+}
+
+int ProfilerOverlay::getIdealHeight() const noexcept
+{
+    // one line per deck plus the summary
+    return (4 + profiler.getNumDecks()) * lineHeight + 2 * padding;
+}
+
+void ProfilerOverlay::timerCallback()
+{
+    if (!isShowing())
+        return;
+
+    // the frame turns red for one refresh after new misses
+    const auto misses = profiler.getDeadlineMisses();
+    missedSinceRefresh = misses > missesShown;
+    missesShown = misses;
+
+    lines.clear();
+    lines.addLines(profiler.getReport());
+    repaint();
+}
+
+void ProfilerOverlay::paint(juce::Graphics& g)
+{
+    g.setColour(juce::Colours::black.withAlpha(0.75f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 6.0f);
+
+    g.setColour(missedSinceRefresh ? juce::Colours::red : juce::Colours::grey);
+    g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), 6.0f, 1.0f);
+
+    g.setColour(juce::Colours::white);
+    g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 13.0f, juce::Font::plain));
+
+    auto area = getLocalBounds().reduced(padding);
+    for (const auto& line : lines)
+        g.drawText(line, area.removeFromTop(lineHeight), juce::Justification::centredLeft, true);
+}
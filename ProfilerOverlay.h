@@ -0,0 +1,32 @@
+#pragma once
+#include <JuceHeader.h>
+#include "CallbackProfiler.h"
+
+// Draws the profiler's report over the decks, refreshed a few times a second.
+// Clicks go through to whatever is underneath.
+class ProfilerOverlay : public juce::Component,
+	private juce::Timer
+{
+public:
+	// the profiler is not owned and must outlive the overlay
+	explicit ProfilerOverlay(CallbackProfiler& profilerToShow);
+	~ProfilerOverlay() override;
+
+	// Height that fits the report
+	int getIdealHeight() const noexcept;
+
+	void paint(juce::Graphics& g) override;
+
+private:
+	void timerCallback() override;
+
+	static constexpr int lineHeight = 16;
+	static constexpr int padding = 8;
+
+	CallbackProfiler& profiler;
+	juce::StringArray lines;
+	juce::int64 missesShown = 0;
+	bool missedSinceRefresh = false;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProfilerOverlay)
+};
@@ -0,0 +1,159 @@
+#include "ReadAheadReader.h"
+
+ReadAheadReader::ReadAheadReader(juce::AudioFormatReader* sourceReader,
+    juce::TimeSliceThread& threadToUse,
+    int samplesToBuffer,
+    std::atomic<int>& underrunCounter)
+    : juce::AudioFormatReader(nullptr, sourceReader->getFormatName()),
+      source(sourceReader),
+      decodeThread(threadToUse),
+      underruns(underrunCounter)
+{
+    sampleRate = source->sampleRate;
+    bitsPerSample = 32;
+    lengthInSamples = source->lengthInSamples;
+    numChannels = source->numChannels;
+    usesFloatingPointData = true;
+    metadataValues = source->metadataValues;
+
+    capacity = juce::jmax(4096, samplesToBuffer);
+    ring.setSize((int)numChannels, capacity);
+    chunk.setSize((int)numChannels, juce::jmin(8192, capacity / 4));
+
+    decodeThread.addTimeSliceClient(this);
+}
+
+ReadAheadReader::~ReadAheadReader()
+{
+    decodeThread.removeTimeSliceClient(this);
+}
+
+bool ReadAheadReader::readSamples(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+    juce::int64 startSampleInFile, int numSamples)
+{
+    int available = 0;
+    bool served = false;
+
+    if (segmentServed.load(std::memory_order_acquire) == segmentRequested.load(std::memory_order_relaxed))
+    {
+        const auto from = startSampleInFile - segmentStart.load(std::memory_order_relaxed);
+        const auto done = decoded.load(std::memory_order_acquire);
+        const auto released = consumed.load(std::memory_order_relaxed);
+
+        // where the decoder is, or will get to without being moved
+        if (from >= released && from <= released + capacity)
+        {
+            available = (int)juce::jlimit((juce::int64)0, (juce::int64)numSamples, done - from);
+            copyFromRing(destSamples, numDestChannels, startOffsetInDestBuffer, from, available);
+
+            // the decoder may reuse everything before the end of this read
+            consumed.store(juce::jmax(released, from + numSamples), std::memory_order_release);
+            served = true;
+        }
+    }
+
+    if (!served)
+        requestSegment(startSampleInFile);
+
+    // not decoded yet, or past the end of the file
+    if (available < numSamples)
+    {
+        for (int ch = 0; ch < numDestChannels; ++ch)
+            if (destSamples[ch] != nullptr)
+                juce::FloatVectorOperations::clear(reinterpret_cast<float*>(destSamples[ch]) + startOffsetInDestBuffer + available,
+                    numSamples - available);
+
+        if (startSampleInFile + available < lengthInSamples)
+        {
+            underruns.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ReadAheadReader::copyFromRing(int* const* destSamples, int numDestChannels, int destOffset,
+    juce::int64 from, int num) const noexcept
+{
+    if (num <= 0)
+        return;
+
+    const int ringPos = (int)(from % capacity);
+    const int first = juce::jmin(num, capacity - ringPos);
+
+    for (int ch = 0; ch < numDestChannels; ++ch)
+    {
+        if (destSamples[ch] == nullptr)
+            continue;
+
+        auto* dest = reinterpret_cast<float*>(destSamples[ch]) + destOffset;
+        if (ch < ring.getNumChannels())
+        {
+            juce::FloatVectorOperations::copy(dest, ring.getReadPointer(ch, ringPos), first);
+            if (num > first)
+                juce::FloatVectorOperations::copy(dest + first, ring.getReadPointer(ch), num - first);
+        }
+        else
+        {
+            juce::FloatVectorOperations::clear(dest, num);
+        }
+    }
+}
+
+void ReadAheadReader::requestSegment(juce::int64 position) noexcept
+{
+    requestedStart.store(juce::jmax((juce::int64)0, position), std::memory_order_relaxed);
+
+    // while the decoder hasn't taken up the last request, it will start from the newer position instead
+    const int request = segmentRequested.load(std::memory_order_relaxed);
+    if (segmentServed.load(std::memory_order_acquire) != request)
+        return;
+
+    consumed.store(0, std::memory_order_relaxed);
+    segmentRequested.store(request + 1, std::memory_order_release);
+}
+
+int ReadAheadReader::useTimeSlice()
+{
+    const int request = segmentRequested.load(std::memory_order_acquire);
+    if (request != segmentInUse)
+    {
+        segmentInUse = request;
+        segmentStart.store(requestedStart.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        decoded.store(0, std::memory_order_relaxed);
+        segmentServed.store(request, std::memory_order_release);
+    }
+
+    const auto start = segmentStart.load(std::memory_order_relaxed);
+    const auto released = consumed.load(std::memory_order_acquire);
+    auto done = decoded.load(std::memory_order_relaxed);
+
+    // the reader got ahead of the decoder and played silence meanwhile; no use decoding what it passed
+    if (released > done)
+        done = released;
+
+    const int num = (int)juce::jmin((juce::int64)chunk.getNumSamples(),
+        capacity - (done - released), lengthInSamples - (start + done));
+
+    if (num <= 0)
+    {
+        decoded.store(done, std::memory_order_release);
+        return 10;
+    }
+
+    source->read(&chunk, 0, num, start + done, true, true);
+
+    // the reader never looks at ring samples from done on, nor the decoder at those before released
+    const int ringPos = (int)(done % capacity);
+    const int first = juce::jmin(num, capacity - ringPos);
+    for (int ch = 0; ch < ring.getNumChannels(); ++ch)
+    {
+        ring.copyFrom(ch, ringPos, chunk, ch, 0, first);
+        if (num > first)
+            ring.copyFrom(ch, 0, chunk, ch, first, num - first);
+    }
+
+    decoded.store(done + num, std::memory_order_release);
+    return 0;
+}
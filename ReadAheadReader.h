@@ -0,0 +1,59 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Reader that decodes ahead of the playhead on a background thread into a ring of floats.
+// The audio thread only copies already decoded samples; if they aren't ready yet it gets silence
+// instead of waiting for the decoder, and the miss is counted as an underrun.
+// The ring is handed between the two threads with atomics alone, so unlike juce::BufferingAudioReader
+// a read never takes a lock. A read outside what the decoder has reached, or can reach, moves the
+// decoder there; so does an empty read, which is how the hot cue stage points it at the playhead.
+class ReadAheadReader : public juce::AudioFormatReader,
+                        private juce::TimeSliceClient
+{
+public:
+	// takes ownership of the source
+	ReadAheadReader(juce::AudioFormatReader* sourceReader,
+		juce::TimeSliceThread& threadToUse,
+		int samplesToBuffer,
+		std::atomic<int>& underrunCounter);
+
+	~ReadAheadReader() override;
+
+	// One reader at a time (the audio thread); the destinations hold floats, see usesFloatingPointData
+	bool readSamples(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+		juce::int64 startSampleInFile, int numSamples) override;
+
+private:
+	// decodes the next chunk after the last one, or starts over where a read asked for
+	int useTimeSlice() override;
+
+	// copies ring samples [from, from + num) of the current segment to the destinations
+	void copyFromRing(int* const* destSamples, int numDestChannels, int destOffset, juce::int64 from, int num) const noexcept;
+
+	// the reader asks for a new segment from this file position
+	void requestSegment(juce::int64 position) noexcept;
+
+	std::unique_ptr<juce::AudioFormatReader> source;
+	juce::TimeSliceThread& decodeThread;
+	std::atomic<int>& underruns;
+
+	// decoded audio; segment sample n lives at (n % capacity)
+	juce::AudioBuffer<float> ring;
+	int capacity = 0;
+
+	// decoder only
+	juce::AudioBuffer<float> chunk;
+	int segmentInUse = 0;
+
+	// A segment is a run of the file decoded from one start position. Each number has one writer:
+	// the reader asks for segments and reports how far it has read, the decoder reports how far it
+	// has decoded and which request it is serving.
+	std::atomic<int> segmentRequested{ 0 };        // reader
+	std::atomic<juce::int64> requestedStart{ 0 };  // reader
+	std::atomic<juce::int64> consumed{ 0 };        // reader: segment samples it is done with
+	std::atomic<int> segmentServed{ 0 };           // decoder
+	std::atomic<juce::int64> segmentStart{ 0 };    // decoder
+	std::atomic<juce::int64> decoded{ 0 };         // decoder: segment samples in the ring
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReadAheadReader)
+};
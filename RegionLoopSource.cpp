@@ -0,0 +1,88 @@
+#include "RegionLoopSource.h"
+
+RegionLoopSource::RegionLoopSource(juce::PositionableAudioSource* inputSource)
+    : input(inputSource)
+{
+    jassert(input != nullptr);
+}
+
+void RegionLoopSource::setRegion(bool shouldLoop, juce::int64 startSample, juce::int64 endSample)
+{
+    Region newRegion;
+    newRegion.active = shouldLoop && endSample > startSample;
+    newRegion.start = juce::jmax((juce::int64)0, startSample);
+    newRegion.end = juce::jmax(newRegion.start, endSample);
+
+    region = newRegion;
+}
+
+void RegionLoopSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    input->prepareToPlay(samplesPerBlockExpected, sampleRate);
+}
+
+void RegionLoopSource::releaseResources()
+{
+    input->releaseResources();
+}
+
+void RegionLoopSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    if (!region.active)
+    {
+        input->getNextAudioBlock(bufferToFill);
+        return;
+    }
+
+    // jump into the region if playback is outside it
+    juce::int64 pos = input->getNextReadPosition();
+    if (pos < region.start || pos >= region.end)
+    {
+        pos = region.start;
+        input->setNextReadPosition(pos);
+    }
+
+    int done = 0;
+    while (done < bufferToFill.numSamples)
+    {
+        const int chunk = (int)juce::jmin((juce::int64)(bufferToFill.numSamples - done), region.end - pos);
+
+        juce::AudioSourceChannelInfo part(bufferToFill.buffer, bufferToFill.startSample + done, chunk);
+        input->getNextAudioBlock(part);
+
+        done += chunk;
+        pos += chunk;
+
+        // wrap at the exact sample where the region ends
+        if (pos >= region.end)
+        {
+            pos = region.start;
+            input->setNextReadPosition(pos);
+        }
+    }
+}
+
+void RegionLoopSource::setNextReadPosition(juce::int64 newPosition)
+{
+    input->setNextReadPosition(newPosition);
+}
+
+juce::int64 RegionLoopSource::getNextReadPosition() const
+{
+    return input->getNextReadPosition();
+}
+
+juce::int64 RegionLoopSource::getTotalLength() const
+{
+    return input->getTotalLength();
+}
+
+bool RegionLoopSource::isLooping() const
+{
+    return input->isLooping();
+}
+
+void RegionLoopSource::setLooping(bool shouldLoop)
+{
+    input->setLooping(shouldLoop);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Sits on top of the AudioFormatReaderSource and wraps playback back to the
+// region start at the exact sample where the region ends.
+// Like the rest of the deck's source chain it belongs to the audio thread; PlayerAudio
+// changes the region by sending a command that is applied between blocks.
+class RegionLoopSource : public juce::PositionableAudioSource
+{
+public:
+	// input is not owned and must outlive this source
+	explicit RegionLoopSource(juce::PositionableAudioSource* input);
+
+	// Region in samples of the input; end is exclusive. Takes effect from the next block.
+	void setRegion(bool shouldLoop, juce::int64 startSample, juce::int64 endSample);
+
+	// Whether playback wraps around inside the region
+	bool isRegionActive() const noexcept { return region.active; }
+
+	// AudioSource
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+	void releaseResources() override;
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	// PositionableAudioSource
+	void setNextReadPosition(juce::int64 newPosition) override;
+	juce::int64 getNextReadPosition() const override;
+	juce::int64 getTotalLength() const override;
+	bool isLooping() const override;
+	void setLooping(bool shouldLoop) override;
+
+private:
+	struct Region
+	{
+		bool active = false;
+		juce::int64 start = 0;
+		juce::int64 end = 0;
+	};
+
+	juce::PositionableAudioSource* input;
+	Region region;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RegionLoopSource)
+};
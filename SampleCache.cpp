@@ -0,0 +1,253 @@
+#include "SampleCache.h"
+
+PreloadedAudio::PreloadedAudio(const juce::File& fileToHold, double rate, int channels, juce::int64 length, SampleFormat format)
+    : file(fileToHold),
+      modificationTime(fileToHold.getLastModificationTime().toMilliseconds()),
+      sampleRate(rate),
+      numChannels(channels),
+      lengthInSamples(length),
+      sampleFormat(format)
+{
+    if (sampleFormat == SampleFormat::float32)
+        floatData.resize((size_t)(numChannels * lengthInSamples));
+    else
+        shortData.resize((size_t)(numChannels * lengthInSamples));
+}
+
+juce::int64 PreloadedAudio::getSizeInBytes(int channels, juce::int64 length, SampleFormat format) noexcept
+{
+    const int bytesPerSample = format == SampleFormat::float32 ? (int)sizeof(float) : (int)sizeof(juce::int16);
+    return channels * length * bytesPerSample;
+}
+
+bool PreloadedAudio::read(float* const* dest, int numDestChannels, int destOffset, juce::int64 start, int num) const noexcept
+{
+    const auto ready = getNumReady();
+    const int available = (int)juce::jlimit((juce::int64)0, (juce::int64)num, ready - start);
+
+    for (int ch = 0; ch < numDestChannels; ++ch)
+    {
+        if (dest[ch] == nullptr)
+            continue;
+
+        float* out = dest[ch] + destOffset;
+        if (ch >= numChannels)
+        {
+            juce::FloatVectorOperations::clear(out, num);
+            continue;
+        }
+
+        const auto offset = (size_t)(ch * lengthInSamples + start);
+        if (sampleFormat == SampleFormat::float32)
+        {
+            juce::FloatVectorOperations::copy(out, floatData.data() + offset, available);
+        }
+        else
+        {
+            const juce::int16* in = shortData.data() + offset;
+            for (int i = 0; i < available; ++i)
+                out[i] = in[i] * (1.0f / 32767.0f);
+        }
+
+        juce::FloatVectorOperations::clear(out + available, num - available);
+    }
+
+    // reading past the end of the file isn't a miss
+    return juce::jmin(start + num, lengthInSamples) <= ready;
+}
+
+void PreloadedAudio::decode(juce::AudioFormatReader& reader, const std::function<bool()>& shouldExit)
+{
+    const int chunkSize = 65536;
+    juce::AudioBuffer<float> buffer(numChannels, chunkSize);
+
+    for (juce::int64 pos = 0; pos < lengthInSamples; pos += chunkSize)
+    {
+        if (shouldExit && shouldExit())
+            return;
+
+        const int num = (int)juce::jmin((juce::int64)chunkSize, lengthInSamples - pos);
+        reader.read(&buffer, 0, num, pos, true, numChannels > 1);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* in = buffer.getReadPointer(ch);
+            const auto offset = (size_t)(ch * lengthInSamples + pos);
+
+            if (sampleFormat == SampleFormat::float32)
+            {
+                juce::FloatVectorOperations::copy(floatData.data() + offset, in, num);
+            }
+            else
+            {
+                juce::int16* out = shortData.data() + offset;
+                for (int i = 0; i < num; ++i)
+                    out[i] = (juce::int16)juce::roundToInt(juce::jlimit(-1.0f, 1.0f, in[i]) * 32767.0f);
+            }
+        }
+
+        numReady.store(pos + num, std::memory_order_release);
+    }
+}
+
+//==============================================================================
+PreloadedAudioReader::PreloadedAudioReader(PreloadedAudio::Ptr audioToRead, std::atomic<int>& underrunCounter)
+    : juce::AudioFormatReader(nullptr, "Preloaded audio"),
+      audio(std::move(audioToRead)),
+      underruns(underrunCounter)
+{
+    sampleRate = audio->sampleRate;
+    bitsPerSample = 32;
+    lengthInSamples = audio->lengthInSamples;
+    numChannels = (unsigned int)audio->numChannels;
+    usesFloatingPointData = true;
+}
+
+bool PreloadedAudioReader::readSamples(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+    juce::int64 startSampleInFile, int numSamples)
+{
+    // usesFloatingPointData, so the destinations hold floats
+    const bool allRead = audio->read(reinterpret_cast<float* const*>(destSamples), numDestChannels,
+        startOffsetInDestBuffer, startSampleInFile, numSamples);
+
+    if (!allRead)
+        underruns.fetch_add(1, std::memory_order_relaxed);
+
+    return allRead;
+}
+
+//==============================================================================
+class SampleCache::DecodeJob : public juce::ThreadPoolJob
+{
+public:
+    DecodeJob(PreloadedAudio::Ptr audioToFill, std::unique_ptr<juce::AudioFormatReader> readerToUse)
+        : juce::ThreadPoolJob("Preload " + audioToFill->file.getFileName()),
+          audio(std::move(audioToFill)), reader(std::move(readerToUse))
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        audio->decode(*reader, [this] { return shouldExit(); });
+        return jobHasFinished;
+    }
+
+private:
+    // holding a reference keeps the buffer from being dropped while it is filled
+    PreloadedAudio::Ptr audio;
+    std::unique_ptr<juce::AudioFormatReader> reader;
+};
+
+SampleCache::SampleCache()
+{
+    formatManager.registerBasicFormats();
+}
+
+SampleCache::~SampleCache()
+{
+    struct DecodeJobs : public juce::ThreadPool::JobSelector
+    {
+        bool isJobSuitable(juce::ThreadPoolJob* job) override { return dynamic_cast<DecodeJob*>(job) != nullptr; }
+    } decodeJobs;
+
+    decodeThreads->getJobPool().removeAllJobs(true, 4000, &decodeJobs);
+}
+
+PreloadedAudio::Ptr SampleCache::get(const juce::File& file, PreloadedAudio::SampleFormat format)
+{
+    const auto modificationTime = file.getLastModificationTime().toMilliseconds();
+
+    auto findAndTouch = [&]() -> PreloadedAudio::Ptr
+        {
+            for (int i = 0; i < entries.size(); ++i)
+            {
+                PreloadedAudio::Ptr entry = entries.getObjectPointerUnchecked(i);
+                if (entry->file == file && entry->modificationTime == modificationTime && entry->sampleFormat == format)
+                {
+                    // most recently used goes last
+                    entries.move(i, -1);
+                    return entry;
+                }
+            }
+            return nullptr;
+        };
+
+    {
+        const juce::ScopedLock sl(lock);
+        if (auto entry = findAndTouch())
+            return entry;
+    }
+
+    // open the file without holding the lock
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0)
+        return nullptr;
+
+    const int channels = (int)juce::jlimit(1u, 2u, reader->numChannels);
+    const auto size = PreloadedAudio::getSizeInBytes(channels, reader->lengthInSamples, format);
+
+    if (size > getMemoryBudget())
+        return nullptr;
+
+    // the buffer is allocated and, if it isn't needed after all, freed without holding the lock;
+    // declared before the lock so it is released after it
+    PreloadedAudio::Ptr audio = new PreloadedAudio(file, reader->sampleRate, channels, reader->lengthInSamples, format);
+    juce::ReferenceCountedArray<PreloadedAudio> dropped;
+
+    const juce::ScopedLock sl(lock);
+
+    // another deck may have asked for the same file in the meantime
+    if (auto entry = findAndTouch())
+        return entry;
+
+    if (!makeRoomFor(size, dropped))
+        return nullptr;
+
+    entries.add(audio);
+    memoryUsed += size;
+
+    decodeThreads->getJobPool().addJob(new DecodeJob(audio, std::move(reader)), true);
+    return audio;
+}
+
+bool SampleCache::makeRoomFor(juce::int64 bytesNeeded, juce::ReferenceCountedArray<PreloadedAudio>& dropped)
+{
+    // a reference count of one means only the cache holds the buffer
+    for (int i = 0; i < entries.size() && memoryUsed + bytesNeeded > memoryBudget;)
+    {
+        auto* entry = entries.getObjectPointerUnchecked(i);
+        if (entry->getReferenceCount() == 1)
+        {
+            memoryUsed -= entry->getSizeInBytes();
+            dropped.add(entry);
+            entries.remove(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    return memoryUsed + bytesNeeded <= memoryBudget;
+}
+
+void SampleCache::setMemoryBudget(juce::int64 bytes)
+{
+    juce::ReferenceCountedArray<PreloadedAudio> dropped;
+
+    const juce::ScopedLock sl(lock);
+    memoryBudget = juce::jmax((juce::int64)0, bytes);
+    makeRoomFor(0, dropped);
+}
+
+juce::int64 SampleCache::getMemoryBudget() const
+{
+    const juce::ScopedLock sl(lock);
+    return memoryBudget;
+}
+
+juce::int64 SampleCache::getMemoryUsed() const
+{
+    const juce::ScopedLock sl(lock);
+    return memoryUsed;
+}
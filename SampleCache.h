@@ -0,0 +1,99 @@
+#pragma once
+#include <JuceHeader.h>
+#include "DecodeThreadPool.h"
+
+// A whole file decoded into memory (at most two channels), shared by reference count between
+// every deck playing it. Decoding runs on a background thread from the start of the file; samples
+// before getNumReady() never change again and may be read from any thread.
+class PreloadedAudio : public juce::ReferenceCountedObject
+{
+public:
+	using Ptr = juce::ReferenceCountedObjectPtr<PreloadedAudio>;
+
+	// int16 halves the memory at the cost of 16-bit resolution
+	enum class SampleFormat { float32, int16 };
+
+	PreloadedAudio(const juce::File& fileToHold, double rate, int channels, juce::int64 length, SampleFormat format);
+
+	static juce::int64 getSizeInBytes(int channels, juce::int64 length, SampleFormat format) noexcept;
+	juce::int64 getSizeInBytes() const noexcept { return getSizeInBytes(numChannels, lengthInSamples, sampleFormat); }
+
+	juce::int64 getNumReady() const noexcept { return numReady.load(std::memory_order_acquire); }
+	bool isComplete() const noexcept { return getNumReady() >= lengthInSamples; }
+
+	// Copies samples as float; null destinations are skipped and anything not decoded yet is silence.
+	// Returns false if some of the range wasn't decoded yet.
+	bool read(float* const* dest, int numDestChannels, int destOffset, juce::int64 start, int num) const noexcept;
+
+	// Decodes the file from the start; called once, on a background thread
+	void decode(juce::AudioFormatReader& reader, const std::function<bool()>& shouldExit);
+
+	const juce::File file;
+	const juce::int64 modificationTime;
+	const double sampleRate;
+	const int numChannels;
+	const juce::int64 lengthInSamples;
+	const SampleFormat sampleFormat;
+
+private:
+	// planar: channel c starts at c * lengthInSamples
+	std::vector<float> floatData;
+	std::vector<juce::int16> shortData;
+
+	std::atomic<juce::int64> numReady{ 0 };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PreloadedAudio)
+};
+
+// Reader over a PreloadedAudio, for decks in RAM preload mode. Never touches the disk; samples that
+// aren't decoded yet come out as silence and are counted as an underrun.
+class PreloadedAudioReader : public juce::AudioFormatReader
+{
+public:
+	PreloadedAudioReader(PreloadedAudio::Ptr audioToRead, std::atomic<int>& underrunCounter);
+
+	bool readSamples(int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+		juce::int64 startSampleInFile, int numSamples) override;
+
+private:
+	PreloadedAudio::Ptr audio;
+	std::atomic<int>& underruns;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PreloadedAudioReader)
+};
+
+// The decoded files of every deck in RAM preload mode, within one memory budget.
+// A file already in the cache is shared, not decoded again. When a new file doesn't fit, buffers that
+// no deck is using are dropped, least recently used first.
+// Shared through juce::SharedResourcePointer and safe to call from any thread.
+class SampleCache
+{
+public:
+	SampleCache();
+	~SampleCache();
+
+	// The file's shared buffer in this format, starting a background decode if it isn't cached yet.
+	// nullptr if the file can't be opened or doesn't fit even after dropping unused buffers.
+	PreloadedAudio::Ptr get(const juce::File& file, PreloadedAudio::SampleFormat format);
+
+	void setMemoryBudget(juce::int64 bytes);
+	juce::int64 getMemoryBudget() const;
+	juce::int64 getMemoryUsed() const;
+
+private:
+	class DecodeJob;
+
+	// Drops unused buffers, least recently used first, until bytesNeeded more fit; call with lock held.
+	// The buffers are moved to dropped, to be freed once the lock is released.
+	bool makeRoomFor(juce::int64 bytesNeeded, juce::ReferenceCountedArray<PreloadedAudio>& dropped);
+
+	juce::AudioFormatManager formatManager;
+	juce::SharedResourcePointer<DecodeThreadPool> decodeThreads;
+
+	juce::CriticalSection lock;
+	juce::ReferenceCountedArray<PreloadedAudio> entries; // least recently used first
+	juce::int64 memoryBudget = (juce::int64)512 * 1024 * 1024;
+	juce::int64 memoryUsed = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleCache)
+};
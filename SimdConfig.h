@@ -0,0 +1,19 @@
+#pragma once
+
+// Which vector instruction set the kernels are compiled for, picked from the compiler's target.
+// Include only from .cpp files: it pulls in the intrinsics headers.
+#if defined(__AVX__)
+ #include <immintrin.h>
+ #define SIMD_KERNELS_AVX 1
+ #define SIMD_KERNELS_NAME "AVX"
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define SIMD_KERNELS_SSE2 1
+ #define SIMD_KERNELS_NAME "SSE2"
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+ #include <arm_neon.h>
+ #define SIMD_KERNELS_NEON 1
+ #define SIMD_KERNELS_NAME "NEON"
+#else
+ #define SIMD_KERNELS_NAME "scalar"
+#endif
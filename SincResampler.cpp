@@ -0,0 +1,260 @@
+#include "SincResampler.h"
+#include "DspKernels.h"
+
+namespace
+{
+    // stopband around -70 dB with 32 taps
+    const double kaiserBeta = 7.0;
+
+    // leaves a transition band below the lower Nyquist frequency
+    const double passbandEdge = 0.95;
+
+    double besselI0(double x) noexcept
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // cutoff as a fraction of the input's Nyquist frequency
+    double cutoffFor(double maxRatio) noexcept
+    {
+        return passbandEdge / juce::jmax(1.0, maxRatio);
+    }
+}
+
+//==============================================================================
+SincFilterBank::SincFilterBank()
+{
+    // rational ratios as (up, down): output rate = input rate * up / down
+    const std::pair<int, int> exactRatios[] = {
+        { 1, 1 },       // same rate
+        { 160, 147 },   // 44.1k -> 48k
+        { 147, 160 },   // 48k -> 44.1k
+        { 2, 1 },       // 2x up
+        { 1, 2 }        // 2x down
+    };
+
+    for (const auto& r : exactRatios)
+    {
+        const double ratio = (double)r.second / r.first;
+
+        // 1:1 keeps the full band, which makes every tap but one zero
+        auto table = makeTable(r.first, r.first, r.first == r.second ? 1.0 : cutoffFor(ratio));
+        table.upFactor = r.first;
+        table.downFactor = r.second;
+        table.maxRatio = ratio;
+        exactTables.push_back(std::move(table));
+    }
+
+    for (double maxRatio : { 1.0, 1.1, 1.25, 1.5, 2.0, 3.0, 4.0, 6.0, 8.0, 16.0 })
+    {
+        auto table = makeTable(genericPhases + 1, genericPhases, cutoffFor(maxRatio));
+        table.maxRatio = maxRatio;
+        genericTables.push_back(std::move(table));
+    }
+}
+
+SincFilterBank::Table SincFilterBank::makeTable(int numRows, int phasesPerSample, double cutoff)
+{
+    Table table;
+    table.numPhases = numRows;
+    table.coefficients.resize((size_t)(numRows * numTaps));
+
+    const int halfTaps = numTaps / 2;
+    const double windowScale = 1.0 / besselI0(kaiserBeta);
+
+    for (int row = 0; row < numRows; ++row)
+    {
+        // row r interpolates r / phasesPerSample of the way from tap halfTaps - 1 to the next
+        const double offset = (double)row / phasesPerSample;
+        auto* coefficients = table.coefficients.data() + row * numTaps;
+        double sum = 0.0;
+
+        for (int k = 0; k < numTaps; ++k)
+        {
+            const double distance = k - (halfTaps - 1) - offset;
+            const double x = juce::MathConstants<double>::pi * cutoff * distance;
+            const double sinc = std::abs(x) < 1.0e-9 ? 1.0 : std::sin(x) / x;
+
+            const double w = distance / halfTaps;
+            const double window = besselI0(kaiserBeta * std::sqrt(juce::jmax(0.0, 1.0 - w * w))) * windowScale;
+
+            const double value = cutoff * sinc * window;
+            coefficients[k] = (float)value;
+            sum += value;
+        }
+
+        // unity gain at DC for every phase
+        for (int k = 0; k < numTaps; ++k)
+            coefficients[k] = (float)(coefficients[k] / sum);
+    }
+
+    return table;
+}
+
+const SincFilterBank::Table* SincFilterBank::findExact(double ratio) const noexcept
+{
+    for (const auto& table : exactTables)
+        if (std::abs(ratio - table.maxRatio) < 1.0e-9)
+            return &table;
+
+    return nullptr;
+}
+
+const SincFilterBank::Table& SincFilterBank::findGeneric(double ratio) const noexcept
+{
+    for (const auto& table : genericTables)
+        if (ratio <= table.maxRatio + 1.0e-9)
+            return table;
+
+    return genericTables.back();
+}
+
+//==============================================================================
+SincResamplingSource::SincResamplingSource(juce::AudioSource* inputSource, bool shouldPrepareInput)
+    : input(inputSource),
+      preparesInput(shouldPrepareInput)
+{
+    jassert(input != nullptr);
+    setResamplingRatio(1.0);
+}
+
+void SincResamplingSource::setResamplingRatio(double newRatio) noexcept
+{
+    ratio = juce::jlimit(1.0e-3, maxRatio, newRatio);
+    exactTable = filterBank->findExact(ratio);
+    genericTable = &filterBank->findGeneric(ratio);
+
+    // carry the position over to the exact table's phase grid
+    if (exactTable != nullptr)
+        phase = juce::jlimit(0, exactTable->upFactor - 1, (int)(fraction * exactTable->upFactor));
+}
+
+void SincResamplingSource::flushBuffers() noexcept
+{
+    history.clear();
+
+    // silence before the first sample, so the first output is centred on it
+    historyFill = juce::jmin(halfTaps - 1, history.getNumSamples());
+    readIndex = 0;
+    fraction = 0.0;
+    phase = 0;
+}
+
+void SincResamplingSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    history.setSize(numChannels, SincFilterBank::numTaps + 2 + (int)std::ceil(samplesPerBlockExpected * maxRatio));
+
+    if (preparesInput)
+        input->prepareToPlay(juce::roundToInt(samplesPerBlockExpected * ratio), sampleRate * ratio);
+
+    flushBuffers();
+}
+
+void SincResamplingSource::releaseResources()
+{
+    if (preparesInput)
+        input->releaseResources();
+}
+
+void SincResamplingSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    const int numOutputChannels = juce::jmin(numChannels, bufferToFill.buffer->getNumChannels());
+
+    // blocks larger than prepared for are split so the input always fits into history
+    const int maxChunk = juce::jmax(1, (int)((history.getNumSamples() - SincFilterBank::numTaps - 2) / ratio));
+
+    for (int done = 0; done < bufferToFill.numSamples;)
+    {
+        const int num = juce::jmin(bufferToFill.numSamples - done, maxChunk);
+
+        float* outputs[numChannels] = {};
+        for (int ch = 0; ch < numOutputChannels; ++ch)
+            outputs[ch] = bufferToFill.buffer->getWritePointer(ch, bufferToFill.startSample + done);
+
+        render(outputs, numOutputChannels, num);
+        done += num;
+    }
+
+    for (int ch = numOutputChannels; ch < bufferToFill.buffer->getNumChannels(); ++ch)
+        bufferToFill.buffer->clear(ch, bufferToFill.startSample, bufferToFill.numSamples);
+}
+
+void SincResamplingSource::fillHistory(int needed) noexcept
+{
+    if (readIndex > 0)
+    {
+        const int remaining = historyFill - readIndex;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* data = history.getWritePointer(ch);
+            std::memmove(data, data + readIndex, sizeof(float) * (size_t)remaining);
+        }
+
+        historyFill = remaining;
+        readIndex = 0;
+    }
+
+    if (historyFill < needed)
+    {
+        juce::AudioSourceChannelInfo info(&history, historyFill, needed - historyFill);
+        input->getNextAudioBlock(info);
+        historyFill = needed;
+    }
+}
+
+void SincResamplingSource::render(float* const* outputs, int numOutputChannels, int num) noexcept
+{
+    // taps of the last output, plus one for rounding
+    fillHistory((int)(fraction + (num - 1) * ratio) + SincFilterBank::numTaps + 1);
+
+    const float* in[numChannels] = { history.getReadPointer(0), history.getReadPointer(1) };
+    constexpr int taps = SincFilterBank::numTaps;
+
+    if (exactTable != nullptr)
+    {
+        const int up = exactTable->upFactor;
+        const int down = exactTable->downFactor;
+
+        for (int i = 0; i < num; ++i)
+        {
+            const float* row = exactTable->getPhase(phase);
+            for (int ch = 0; ch < numOutputChannels; ++ch)
+                outputs[ch][i] = DspKernels::dotProduct(in[ch] + readIndex, row, taps);
+
+            phase += down;
+            readIndex += phase / up;
+            phase %= up;
+        }
+
+        fraction = (double)phase / up;
+        return;
+    }
+
+    const auto& table = *genericTable;
+    for (int i = 0; i < num; ++i)
+    {
+        const double position = fraction * SincFilterBank::genericPhases;
+        const int row = (int)position;
+        const float blend = (float)(position - row);
+
+        const float* rowA = table.getPhase(row);
+        const float* rowB = table.getPhase(row + 1);
+        for (int ch = 0; ch < numOutputChannels; ++ch)
+        {
+            const float a = DspKernels::dotProduct(in[ch] + readIndex, rowA, taps);
+            const float b = DspKernels::dotProduct(in[ch] + readIndex, rowB, taps);
+            outputs[ch][i] = a + blend * (b - a);
+        }
+
+        fraction += ratio;
+        const int step = (int)fraction;
+        readIndex += step;
+        fraction -= step;
+    }
+}
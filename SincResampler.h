@@ -0,0 +1,102 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Polyphase windowed-sinc (Kaiser) filters for the sinc resampler, built once per process.
+// Shared through juce::SharedResourcePointer; read-only after construction, so any thread may use it.
+//
+// Exact tables hold one phase per output sample of a rational ratio (44.1k <-> 48k, 2x, 0.5x, 1:1)
+// and are stepped with integer arithmetic. Every other ratio, e.g. any speed setting, uses a
+// 256-phase table interpolated between neighbouring phases, picked by how far the cutoff must drop.
+class SincFilterBank
+{
+public:
+	// taps per phase; a multiple of 8 so every row is whole vectors
+	static constexpr int numTaps = 32;
+	static constexpr int genericPhases = 256;
+
+	struct Table
+	{
+		// exact tables: numPhases == upFactor, ratio == downFactor / upFactor;
+		// generic tables: upFactor == 0 and one extra row to interpolate towards
+		int numPhases = 0;
+		int upFactor = 0;
+		int downFactor = 0;
+
+		// highest ratio (input samples per output sample) the cutoff is low enough for
+		double maxRatio = 1.0;
+
+		std::vector<float> coefficients;
+
+		const float* getPhase(int phase) const noexcept { return coefficients.data() + phase * numTaps; }
+	};
+
+	SincFilterBank();
+
+	// the exact table for this ratio, or nullptr if there is none
+	const Table* findExact(double ratio) const noexcept;
+
+	// the generic table with the highest cutoff that still suits this ratio
+	const Table& findGeneric(double ratio) const noexcept;
+
+private:
+	static Table makeTable(int numRows, int phasesPerSample, double cutoff);
+
+	std::vector<Table> exactTables;
+	std::vector<Table> genericTables;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SincFilterBank)
+};
+
+// Drop-in alternative to juce::ResamplingAudioSource using SincFilterBank, for both speed change
+// and file-to-device rate conversion. The inner loop is DspKernels::dotProduct.
+// Buffers are sized in prepareToPlay; changing the ratio only swaps tables and never allocates.
+class SincResamplingSource : public juce::AudioSource
+{
+public:
+	// Input is not owned and must outlive this source. Without preparesInput, prepareToPlay and
+	// releaseResources leave the input alone, for an input another resampler already prepares.
+	explicit SincResamplingSource(juce::AudioSource* input, bool preparesInput = true);
+
+	// Input samples consumed per output sample; safe to call from the audio thread
+	void setResamplingRatio(double newRatio) noexcept;
+	double getResamplingRatio() const noexcept { return ratio; }
+
+	// Drops the filter history, e.g. after the input was repositioned
+	void flushBuffers() noexcept;
+
+	// AudioSource
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+	void releaseResources() override;
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+private:
+	static constexpr int numChannels = 2;
+	static constexpr int halfTaps = SincFilterBank::numTaps / 2;
+	static constexpr double maxRatio = 16.0;
+
+	// makes sure history holds this many samples, moving unused ones to the front first
+	void fillHistory(int needed) noexcept;
+
+	// writes num output samples starting at the first sample of the output channels
+	void render(float* const* outputs, int numOutputChannels, int num) noexcept;
+
+	juce::AudioSource* input;
+	const bool preparesInput;
+	juce::SharedResourcePointer<SincFilterBank> filterBank;
+
+	double ratio = 1.0;
+	const SincFilterBank::Table* exactTable = nullptr;
+	const SincFilterBank::Table* genericTable = nullptr;
+
+	// input samples; the next output's first tap is at readIndex
+	juce::AudioBuffer<float> history;
+	int historyFill = 0;
+	int readIndex = 0;
+
+	// position between readIndex + halfTaps - 1 and the next sample: fraction for generic tables,
+	// phase for exact ones
+	double fraction = 0.0;
+	int phase = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SincResamplingSource)
+};
@@ -0,0 +1,283 @@
+#include "TimeStretchSource.h"
+#include "DspKernels.h"
+
+TimeStretchSource::TimeStretchSource(juce::AudioSource* inputSource)
+    : input(inputSource)
+{
+    jassert(input != nullptr);
+}
+
+double TimeStretchSource::getFrameSeconds(Quality q) noexcept
+{
+    switch (q)
+    {
+    case Quality::lowLatency:  return 0.02;
+    case Quality::balanced:    return 0.04;
+    case Quality::highQuality: return 0.08;
+    }
+
+    return 0.04;
+}
+
+void TimeStretchSource::setEnabled(bool shouldBeEnabled) noexcept
+{
+    if (enabled == shouldBeEnabled)
+        return;
+
+    enabled = shouldBeEnabled;
+    reset();
+}
+
+void TimeStretchSource::setInputSampleRate(double newSampleRate) noexcept
+{
+    inputSampleRate = newSampleRate;
+
+    const double rate = getWorkingSampleRate();
+    if (rate == sampleRate)
+        return;
+
+    sampleRate = rate;
+    updateSizes();
+    reset();
+}
+
+double TimeStretchSource::getWorkingSampleRate() const noexcept
+{
+    const double rate = inputSampleRate > 0.0 ? inputSampleRate : preparedSampleRate;
+    return juce::jmin(rate, capacitySampleRate);
+}
+
+void TimeStretchSource::setQuality(Quality newQuality) noexcept
+{
+    if (quality == newQuality)
+        return;
+
+    quality = newQuality;
+    updateSizes();
+    reset();
+}
+
+void TimeStretchSource::reset() noexcept
+{
+    inputStart = 0;
+    inputFill = 0;
+    analysisPos = 0.0;
+    previousFrameStart = 0;
+    hasPreviousFrame = false;
+
+    overlapBuffer.clear();
+    frameOutputPos = hopSize;
+}
+
+juce::int64 TimeStretchSource::getInputLead() const noexcept
+{
+    if (!enabled)
+        return 0;
+
+    return inputStart + inputFill - (hasPreviousFrame ? previousFrameStart : inputStart);
+}
+
+void TimeStretchSource::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    preparedSampleRate = newSampleRate;
+    capacitySampleRate = juce::jmax(newSampleRate, maxInputSampleRate);
+    sampleRate = getWorkingSampleRate();
+    blockSize = samplesPerBlockExpected;
+
+    // room for the largest preset at the highest tempo and input rate: the next frame's search range
+    // can lie several hops beyond the natural continuation of the previous frame
+    const int maxFrame = (int)std::ceil(getFrameSeconds(Quality::highQuality) * capacitySampleRate) + 8;
+    const int maxSearch = (int)std::ceil(0.015 * capacitySampleRate);
+    const int capacity = (int)std::ceil(maxTempo * maxFrame / 2) + maxFrame + 2 * maxSearch + blockSize;
+
+    inputBuffer.setSize(numChannels, capacity);
+    inputMono.assign((size_t)capacity, 0.0f);
+    window.reserve((size_t)maxFrame);
+    overlapBuffer.setSize(numChannels, maxFrame);
+    frameOutput.setSize(numChannels, maxFrame / 2);
+
+    input->prepareToPlay(samplesPerBlockExpected, newSampleRate);
+
+    updateSizes();
+    reset();
+}
+
+void TimeStretchSource::releaseResources()
+{
+    input->releaseResources();
+}
+
+void TimeStretchSource::updateSizes() noexcept
+{
+    if (sampleRate <= 0.0)
+        return;
+
+    const double searchSeconds = quality == Quality::lowLatency ? 0.005
+                               : quality == Quality::balanced ? 0.01
+                               : 0.015;
+
+    // a multiple of 8 keeps the hop a whole number of vectors
+    frameSize = juce::jmax(64, (int)(getFrameSeconds(quality) * sampleRate) / 8 * 8);
+    hopSize = frameSize / 2;
+    searchRadius = (int)(searchSeconds * sampleRate);
+
+    // periodic Hann: frames overlapping by half sum to exactly one
+    window.resize((size_t)frameSize);
+    for (int i = 0; i < frameSize; ++i)
+        window[(size_t)i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float)i / (float)frameSize);
+}
+
+void TimeStretchSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    if (!enabled)
+    {
+        const auto startTicks = timing ? juce::Time::getHighResolutionTicks() : 0;
+
+        lastBlockLoad = 0.0f;
+        input->getNextAudioBlock(bufferToFill);
+
+        if (timing)
+            busyTicks += juce::Time::getHighResolutionTicks() - startTicks;
+        return;
+    }
+
+    // always timed while stretching, for getLastBlockLoad()
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    const int channelsToFill = juce::jmin(numChannels, bufferToFill.buffer->getNumChannels());
+
+    int done = 0;
+    while (done < bufferToFill.numSamples)
+    {
+        if (frameOutputPos >= hopSize)
+            processFrame();
+
+        const int num = juce::jmin(bufferToFill.numSamples - done, hopSize - frameOutputPos);
+        for (int ch = 0; ch < channelsToFill; ++ch)
+            bufferToFill.buffer->copyFrom(ch, bufferToFill.startSample + done, frameOutput, ch, frameOutputPos, num);
+
+        frameOutputPos += num;
+        done += num;
+    }
+
+    for (int ch = channelsToFill; ch < bufferToFill.buffer->getNumChannels(); ++ch)
+        bufferToFill.buffer->clear(ch, bufferToFill.startSample, bufferToFill.numSamples);
+
+    const auto elapsed = juce::Time::getHighResolutionTicks() - startTicks;
+    if (timing)
+        busyTicks += elapsed;
+
+    const double seconds = juce::Time::highResolutionTicksToSeconds(elapsed);
+    lastBlockLoad = (float)(seconds * sampleRate / juce::jmax(1, bufferToFill.numSamples));
+}
+
+void TimeStretchSource::processFrame() noexcept
+{
+    const auto ideal = (juce::int64)std::llround(analysisPos);
+    const auto natural = hasPreviousFrame ? previousFrameStart + hopSize : ideal;
+    const auto lowest = juce::jmax(inputStart, ideal - searchRadius);
+    const auto highest = ideal + searchRadius;
+
+    readInputUpTo(juce::jmax(highest, natural) + frameSize);
+
+    const auto start = hasPreviousFrame ? findBestFrameStart(lowest, highest, natural) : ideal;
+    const int offset = (int)(start - inputStart);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* overlap = overlapBuffer.getWritePointer(ch);
+
+        // window the frame onto the tail of the previous one; the first hop is then complete
+        juce::FloatVectorOperations::addWithMultiply(overlap, inputBuffer.getReadPointer(ch, offset), window.data(), frameSize);
+        frameOutput.copyFrom(ch, 0, overlapBuffer, ch, 0, hopSize);
+
+        std::memmove(overlap, overlap + hopSize, sizeof(float) * (size_t)(frameSize - hopSize));
+        juce::FloatVectorOperations::clear(overlap + frameSize - hopSize, hopSize);
+    }
+
+    frameOutputPos = 0;
+    previousFrameStart = start;
+    hasPreviousFrame = true;
+    analysisPos += hopSize * tempo;
+
+    // keep what the next frame's search and its natural continuation can still reach
+    discardInputBefore(juce::jmin((juce::int64)std::llround(analysisPos) - searchRadius, start + hopSize));
+}
+
+juce::int64 TimeStretchSource::findBestFrameStart(juce::int64 lowest, juce::int64 highest, juce::int64 natural) const noexcept
+{
+    // compare the start of each candidate with the audio that naturally follows the previous frame
+    const float* reference = inputMono.data() + (natural - inputStart);
+    auto similarity = [&](juce::int64 candidate)
+        {
+            return DspKernels::dotProduct(inputMono.data() + (candidate - inputStart), reference, hopSize);
+        };
+
+    // every few samples first, then every sample around the best match
+    const int coarseStep = 4;
+    auto best = lowest;
+    float bestScore = std::numeric_limits<float>::lowest();
+
+    for (auto candidate = lowest; candidate <= highest; candidate += coarseStep)
+    {
+        const float score = similarity(candidate);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = candidate;
+        }
+    }
+
+    const auto fineLowest = juce::jmax(lowest, best - coarseStep + 1);
+    const auto fineHighest = juce::jmin(highest, best + coarseStep - 1);
+    for (auto candidate = fineLowest; candidate <= fineHighest; ++candidate)
+    {
+        const float score = similarity(candidate);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = candidate;
+        }
+    }
+
+    return best;
+}
+
+void TimeStretchSource::readInputUpTo(juce::int64 end) noexcept
+{
+    const int capacity = inputBuffer.getNumSamples();
+
+    while (inputStart + inputFill < end && inputFill < capacity)
+    {
+        const auto missing = end - (inputStart + inputFill);
+        const int num = (int)juce::jmin((juce::int64)(capacity - inputFill), juce::jmax((juce::int64)blockSize, missing));
+
+        juce::AudioSourceChannelInfo info(&inputBuffer, inputFill, num);
+        input->getNextAudioBlock(info);
+
+        // the search runs on the sum of both channels
+        float* mono = inputMono.data() + inputFill;
+        juce::FloatVectorOperations::copy(mono, inputBuffer.getReadPointer(0, inputFill), num);
+        juce::FloatVectorOperations::add(mono, inputBuffer.getReadPointer(1, inputFill), num);
+
+        inputFill += num;
+    }
+}
+
+void TimeStretchSource::discardInputBefore(juce::int64 start) noexcept
+{
+    const int num = (int)juce::jlimit((juce::int64)0, (juce::int64)inputFill, start - inputStart);
+    if (num == 0)
+        return;
+
+    const int remaining = inputFill - num;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* data = inputBuffer.getWritePointer(ch);
+        std::memmove(data, data + num, sizeof(float) * (size_t)remaining);
+    }
+    std::memmove(inputMono.data(), inputMono.data() + num, sizeof(float) * (size_t)remaining);
+
+    inputStart += num;
+    inputFill = remaining;
+}
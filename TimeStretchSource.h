@@ -0,0 +1,119 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Changes tempo without changing pitch, using WSOLA (waveform-similarity overlap-add).
+// Frames of the input are cut at the tempo-scaled positions, each nudged within a small search
+// range to where it best lines up with the audio that precedes it, then cross-faded together with
+// a Hann window at a fixed output hop. The search is a vectorised cross-correlation.
+//
+// When disabled the input is passed straight through. All buffers are sized for the largest
+// preset in prepareToPlay, so changing tempo, preset or enabled state never allocates.
+// Everything except the constructor and prepareToPlay is for the audio thread only.
+class TimeStretchSource : public juce::AudioSource
+{
+public:
+	// Quality against latency: longer frames and a wider search smear transients less
+	// on tonal material but add delay
+	enum class Quality { lowLatency, balanced, highQuality };
+
+	// input is not owned and must outlive this source
+	explicit TimeStretchSource(juce::AudioSource* input);
+
+	void setEnabled(bool shouldBeEnabled) noexcept;
+	bool isEnabled() const noexcept { return enabled; }
+
+	// Input samples consumed per output sample (2.0 = twice as fast)
+	void setTempo(double newTempo) noexcept { tempo = juce::jlimit(minTempo, maxTempo, newTempo); }
+	static constexpr double minTempo = 0.1;
+	static constexpr double maxTempo = 8.0;
+
+	// Rate of the audio being stretched, which the frame, hop and search sizes follow. Until it is
+	// set, the rate given to prepareToPlay is used. Buffers are sized for up to maxInputSampleRate
+	// (or the prepared rate if higher) and faster input is treated as that rate, so this never allocates.
+	void setInputSampleRate(double newSampleRate) noexcept;
+	static constexpr double maxInputSampleRate = 192000.0;
+
+	void setQuality(Quality newQuality) noexcept;
+
+	// Drops everything buffered, e.g. after the input was repositioned
+	void reset() noexcept;
+
+	// How far the input has been read beyond the audio now being played
+	juce::int64 getInputLead() const noexcept;
+
+	// Processing time of the last block as a fraction of the block's duration
+	float getLastBlockLoad() const noexcept { return lastBlockLoad; }
+
+	// High-resolution ticks spent in getNextAudioBlock since the last call, reading the input included;
+	// counted while timing is on
+	void setTiming(bool shouldTime) noexcept { timing = shouldTime; }
+	juce::int64 takeBusyTicks() noexcept { return std::exchange(busyTicks, (juce::int64)0); }
+
+	// Frame length in seconds for a preset (also roughly the added latency)
+	static double getFrameSeconds(Quality quality) noexcept;
+
+	// AudioSource
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+	void releaseResources() override;
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+private:
+	static constexpr int numChannels = 2;
+
+	// the rate the sizes follow, from the input rate (or the prepared one) within what the buffers allow
+	double getWorkingSampleRate() const noexcept;
+
+	// frame and search sizes of the current preset at the working rate
+	void updateSizes() noexcept;
+
+	// makes sure input up to (but excluding) this absolute index has been read
+	void readInputUpTo(juce::int64 end) noexcept;
+
+	// drops input before this absolute index
+	void discardInputBefore(juce::int64 start) noexcept;
+
+	// cuts, aligns and overlap-adds one frame, leaving hop new samples in frameOutput
+	void processFrame() noexcept;
+
+	// start of the candidate frame that best continues the previous one
+	juce::int64 findBestFrameStart(juce::int64 lowest, juce::int64 highest, juce::int64 natural) const noexcept;
+
+	juce::AudioSource* input;
+
+	bool enabled = false;
+	double tempo = 1.0;
+	Quality quality = Quality::balanced;
+
+	double sampleRate = 0.0;         // working rate
+	double preparedSampleRate = 0.0; // given to prepareToPlay
+	double capacitySampleRate = 0.0; // the buffers are sized for
+	double inputSampleRate = 0.0;    // from setInputSampleRate, 0 if not set
+	int blockSize = 0;
+	int frameSize = 0;
+	int hopSize = 0;
+	int searchRadius = 0;
+
+	// input read so far; index 0 holds absolute input sample inputStart
+	juce::AudioBuffer<float> inputBuffer;
+	std::vector<float> inputMono;
+	juce::int64 inputStart = 0;
+	int inputFill = 0;
+
+	// Hann window of the current frame size
+	std::vector<float> window;
+
+	// overlap-add accumulator (one frame long) and the finished samples waiting to be played
+	juce::AudioBuffer<float> overlapBuffer;
+	juce::AudioBuffer<float> frameOutput;
+	int frameOutputPos = 0;
+
+	double analysisPos = 0.0;
+	juce::int64 previousFrameStart = 0;
+	bool hasPreviousFrame = false;
+
+	float lastBlockLoad = 0.0f;
+	bool timing = false;
+	juce::int64 busyTicks = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimeStretchSource)
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Tags and stream properties of an audio file.
+// Records are immutable once created and shared by reference count, so any thread
+// can keep one for as long as it likes without copying the strings.
+class TrackInfo : public juce::ReferenceCountedObject
+{
+public:
+	using Ptr = juce::ReferenceCountedObjectPtr<TrackInfo>;
+
+	TrackInfo(const juce::File& fileToDescribe,
+		const juce::String& titleToUse,
+		const juce::String& artistToUse,
+		const juce::String& albumToUse,
+		double duration,
+		double rate,
+		int channels)
+		: file(fileToDescribe), title(titleToUse), artist(artistToUse), album(albumToUse),
+		  durationSeconds(duration), sampleRate(rate), numChannels(channels)
+	{
+	}
+
+	// false if the file couldn't be opened as audio
+	bool isValid() const noexcept { return sampleRate > 0.0; }
+
+	// Title if the file has one, otherwise its name without extension
+	juce::String getDisplayName() const { return title.isNotEmpty() ? title : file.getFileNameWithoutExtension(); }
+
+	const juce::File file;
+	const juce::String title;
+	const juce::String artist;
+	const juce::String album;
+	const double durationSeconds;
+	const double sampleRate;
+	const int numChannels;
+
+private:
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackInfo)
+};
@@ -0,0 +1,164 @@
+#include "TrackQueueSource.h"
+
+TrackHandover::~TrackHandover()
+{
+    delete finished.exchange(nullptr);
+    delete next.exchange(nullptr);
+}
+
+void TrackHandover::prepareTrack(DeckTrack& track)
+{
+    if (preparedSampleRate.load() > 0.0)
+        track.loopSource->prepareToPlay(preparedBlockSize.load(), preparedSampleRate.load());
+}
+
+std::unique_ptr<DeckTrack> TrackHandover::queueNextTrack(std::unique_ptr<DeckTrack> track, juce::int64 startPosition, juce::int64 newMixPoint)
+{
+    if (track != nullptr)
+    {
+        prepareTrack(*track);
+        track->loopSource->setNextReadPosition(startPosition);
+    }
+
+    // published before the track, which the audio thread checks first
+    mixPoint.store(newMixPoint, std::memory_order_release);
+    return std::unique_ptr<DeckTrack>(next.exchange(track.release()));
+}
+
+std::unique_ptr<DeckTrack> TrackHandover::clearNextTrack()
+{
+    return std::unique_ptr<DeckTrack>(next.exchange(nullptr));
+}
+
+bool TrackHandover::collectFinishedTrack(std::unique_ptr<DeckTrack>& finishedTrack)
+{
+    finishedTrack.reset(finished.exchange(nullptr));
+
+    const int total = advances.load();
+    const bool advanced = total != advancesCollected;
+    advancesCollected = total;
+    return advanced;
+}
+
+DeckTrack* TrackHandover::startNextTrack(DeckTrack* endedTrack) noexcept
+{
+    // the last finished track hasn't been collected yet, so there is nowhere to hand this one back
+    if (endedTrack != nullptr && finished.load() != nullptr)
+        return nullptr;
+
+    auto* following = next.exchange(nullptr);
+    if (following == nullptr)
+        return nullptr;
+
+    if (endedTrack != nullptr)
+        finished.store(endedTrack);
+
+    lastStarted.store(following);
+    advances.fetch_add(1);
+    return following;
+}
+
+//==============================================================================
+TrackQueueSource::~TrackQueueSource()
+{
+    delete current.exchange(nullptr);
+}
+
+void TrackQueueSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    handover.preparedBlockSize = samplesPerBlockExpected;
+    handover.preparedSampleRate = sampleRate;
+
+    if (auto* track = current.load())
+        track->loopSource->prepareToPlay(samplesPerBlockExpected, sampleRate);
+}
+
+void TrackQueueSource::releaseResources()
+{
+    if (auto* track = current.load())
+        track->loopSource->releaseResources();
+}
+
+void TrackQueueSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto* track = current.load();
+    if (track == nullptr)
+    {
+        bufferToFill.clearActiveBufferRegion();
+        return;
+    }
+
+    const auto startTicks = timing ? juce::Time::getHighResolutionTicks() : 0;
+
+    int done = 0;
+    while (done < bufferToFill.numSamples)
+    {
+        auto* source = track->loopSource.get();
+        int chunk = bufferToFill.numSamples - done;
+
+        // stop exactly at the last sample unless this track wraps around by itself
+        if (!source->isLooping() && !source->isRegionActive())
+            chunk = (int)juce::jlimit((juce::int64)0, (juce::int64)chunk,
+                source->getTotalLength() - source->getNextReadPosition());
+
+        if (chunk > 0)
+        {
+            juce::AudioSourceChannelInfo part(bufferToFill.buffer, bufferToFill.startSample + done, chunk);
+            source->getNextAudioBlock(part);
+            done += chunk;
+        }
+
+        if (done < bufferToFill.numSamples)
+        {
+            if (auto* following = canStartNext ? handover.startNextTrack(track) : nullptr)
+            {
+                current.store(following);
+                track = following;
+                continue;
+            }
+
+            // nothing queued: read past the end like a plain reader source would,
+            // so the deck sees the stream finish
+            juce::AudioSourceChannelInfo rest(bufferToFill.buffer, bufferToFill.startSample + done,
+                bufferToFill.numSamples - done);
+            source->getNextAudioBlock(rest);
+            break;
+        }
+    }
+
+    if (timing)
+        busyTicks += juce::Time::getHighResolutionTicks() - startTicks;
+}
+
+void TrackQueueSource::setNextReadPosition(juce::int64 newPosition)
+{
+    if (auto* track = current.load())
+        track->loopSource->setNextReadPosition(newPosition);
+}
+
+juce::int64 TrackQueueSource::getNextReadPosition() const
+{
+    if (auto* track = current.load())
+        return track->loopSource->getNextReadPosition();
+    return 0;
+}
+
+juce::int64 TrackQueueSource::getTotalLength() const
+{
+    if (auto* track = current.load())
+        return track->loopSource->getTotalLength();
+    return 0;
+}
+
+bool TrackQueueSource::isLooping() const
+{
+    if (auto* track = current.load())
+        return track->loopSource->isLooping();
+    return false;
+}
+
+void TrackQueueSource::setLooping(bool shouldLoop)
+{
+    if (auto* track = current.load())
+        track->loopSource->setLooping(shouldLoop);
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <JuceHeader.h>
+#include "HotCueReader.h"
+#include "RegionLoopSource.h"
+#include "TrackInfo.h"
+
+// A file opened for playback: its reader source and the region loop stage on top of it.
+struct DeckTrack
+{
+	juce::File file;
+	TrackInfo::Ptr info;
+	double sampleRate = 0.0;
+	std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+	std::unique_ptr<RegionLoopSource> loopSource;
+
+	// hot cue stage of a streamed file, owned by readerSource; null when the whole file is resident anyway
+	HotCueReader* hotCues = nullptr;
+};
+
+// The track queued to follow the current one, and the track that finished, of one deck.
+// Shared by the track queues of the deck's voices, so the message thread can queue and collect
+// without knowing which voice is playing.
+class TrackHandover
+{
+public:
+	TrackHandover() = default;
+	~TrackHandover();
+
+	// Prepares a track with the settings of the last prepareToPlay, before it is handed to the audio thread
+	void prepareTrack(DeckTrack& track);
+
+	// Track to continue with when the current one ends (replaces any track already queued).
+	// It starts at startPosition; mixPoint is where in the current track a crossfade into it begins.
+	// The tracks these hand back (may be null) should be freed away from the message thread,
+	// since closing a streamed file can wait on its read-ahead thread.
+	std::unique_ptr<DeckTrack> queueNextTrack(std::unique_ptr<DeckTrack> track, juce::int64 startPosition = 0, juce::int64 mixPoint = 0);
+	std::unique_ptr<DeckTrack> clearNextTrack();
+	bool hasNextTrack() const noexcept { return next.load() != nullptr; }
+	juce::int64 getMixPoint() const noexcept { return mixPoint.load(std::memory_order_acquire); }
+
+	// Message thread: hands over the track that finished playing (if any) in finishedTrack.
+	// Returns true if playback moved on to a queued track since the last call.
+	bool collectFinishedTrack(std::unique_ptr<DeckTrack>& finishedTrack);
+
+	// The track playback moved on to last; valid until the message thread loads another
+	DeckTrack* getLastStartedTrack() const noexcept { return lastStarted.load(); }
+
+	// Audio thread: takes the queued track, or nullptr if there is none or the last finished
+	// track hasn't been collected yet. endedTrack (may be null) is handed back through collectFinishedTrack().
+	DeckTrack* startNextTrack(DeckTrack* endedTrack) noexcept;
+
+private:
+	friend class TrackQueueSource;
+
+	std::atomic<DeckTrack*> next{ nullptr };
+	std::atomic<DeckTrack*> finished{ nullptr };
+	std::atomic<DeckTrack*> lastStarted{ nullptr };
+	std::atomic<juce::int64> mixPoint{ 0 };
+	std::atomic<int> advances{ 0 };
+	int advancesCollected = 0;
+
+	std::atomic<int> preparedBlockSize{ 0 };
+	std::atomic<double> preparedSampleRate{ 0.0 };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackHandover)
+};
+
+// Plays the current track and, when it runs out, carries on with the queued track
+// from the very next sample, so consecutive playlist entries play without a gap.
+// The switch happens on the audio thread; the track that finished is handed back
+// to the message thread through the TrackHandover so it is never freed while rendering.
+class TrackQueueSource : public juce::PositionableAudioSource
+{
+public:
+	// the handover is not owned and must outlive this source
+	explicit TrackQueueSource(TrackHandover& handoverToUse) : handover(handoverToUse) {}
+	~TrackQueueSource() override;
+
+	// Makes the track current (null for none) and returns the one it replaces, which the caller
+	// must free on the message thread. Call from the audio thread, or while nothing is rendering.
+	DeckTrack* swapCurrentTrack(DeckTrack* track) noexcept { return current.exchange(track); }
+	DeckTrack* getCurrentTrack() const noexcept { return current.load(); }
+
+	// Audio thread: whether running out moves on to the queued track (otherwise the stream just ends)
+	void setCanStartNext(bool shouldStartNext) noexcept { canStartNext = shouldStartNext; }
+
+	// Audio thread: high-resolution ticks spent reading tracks since the last call, counted while timing is on
+	void setTiming(bool shouldTime) noexcept { timing = shouldTime; }
+	juce::int64 takeBusyTicks() noexcept { return std::exchange(busyTicks, (juce::int64)0); }
+
+	// AudioSource
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+	void releaseResources() override;
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	// PositionableAudioSource
+	void setNextReadPosition(juce::int64 newPosition) override;
+	juce::int64 getNextReadPosition() const override;
+	juce::int64 getTotalLength() const override;
+	bool isLooping() const override;
+	void setLooping(bool shouldLoop) override;
+
+private:
+	TrackHandover& handover;
+	std::atomic<DeckTrack*> current{ nullptr };
+	bool canStartNext = true;
+	bool timing = false;
+	juce::int64 busyTicks = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackQueueSource)
+};
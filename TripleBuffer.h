@@ -0,0 +1,41 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Hands the latest value from one writer thread to one reader thread without either ever waiting.
+// The writer fills its own buffer and swaps it into the middle slot; the reader swaps the middle
+// slot out when it holds something newer. Neither side can see a half-written value.
+template <typename Data>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+
+	// Writer: the buffer to fill before calling publish()
+	Data& getWriteBuffer() noexcept { return buffers[writeIndex]; }
+
+	// Writer: makes the filled buffer the latest one
+	void publish() noexcept
+	{
+		writeIndex = middle.exchange(writeIndex | newDataFlag, std::memory_order_acq_rel) & indexMask;
+	}
+
+	// Reader: the latest published value; the reference stays valid until the next read()
+	const Data& read() const noexcept
+	{
+		if ((middle.load(std::memory_order_relaxed) & newDataFlag) != 0)
+			readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+
+		return buffers[readIndex];
+	}
+
+private:
+	static constexpr int indexMask = 3;
+	static constexpr int newDataFlag = 4;
+
+	Data buffers[3]{};
+	int writeIndex = 0;
+	mutable int readIndex = 1;
+	mutable std::atomic<int> middle{ 2 };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TripleBuffer)
+};
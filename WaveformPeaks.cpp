@@ -0,0 +1,286 @@
+#include "WaveformPeaks.h"
+
+namespace
+{
+    const int peakFileMagic = 0x4b504153; // "SAPK"
+    const int peakFileVersion = 1;
+
+    // magic, version, sample rate, length, channels, levels
+    const int headerSize = 4 + 4 + 8 + 8 + 4 + 4;
+    // samples per bucket, number of buckets, data offset
+    const int levelEntrySize = 4 + 8 + 8;
+
+    juce::int16 toPeakValue(float sample) noexcept
+    {
+        return (juce::int16)juce::roundToInt(juce::jlimit(-1.0f, 1.0f, sample) * 32767.0f);
+    }
+}
+
+juce::File WaveformPeaks::getPeakFileFor(const juce::File& audioFile)
+{
+    const juce::String key = audioFile.getFullPathName()
+        + "|" + juce::String(audioFile.getSize())
+        + "|" + juce::String(audioFile.getLastModificationTime().toMilliseconds());
+
+    return getCacheDirectory().getChildFile(juce::String::toHexString(key.hashCode64()) + ".peaks");
+}
+
+juce::File WaveformPeaks::getCacheDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("SimpleAudioPlayer")
+        .getChildFile("Peaks");
+}
+
+void WaveformPeaks::pruneCache(juce::RelativeTime maxAge, juce::int64 maxTotalBytes)
+{
+    struct PeakFile
+    {
+        juce::File file;
+        juce::Time lastUsed;
+        juce::int64 size = 0;
+    };
+
+    // open() bumps the modification time, so that is when each file was last used
+    std::vector<PeakFile> peakFiles;
+    juce::int64 totalBytes = 0;
+    for (const auto& file : getCacheDirectory().findChildFiles(juce::File::findFiles, false, "*.peaks"))
+    {
+        peakFiles.push_back({ file, file.getLastModificationTime(), file.getSize() });
+        totalBytes += peakFiles.back().size;
+    }
+
+    std::sort(peakFiles.begin(), peakFiles.end(),
+        [](const PeakFile& a, const PeakFile& b) { return a.lastUsed < b.lastUsed; });
+
+    // least recently used first, so once one is recent enough and the rest fit, so are all after it
+    const auto oldestKept = juce::Time::getCurrentTime() - maxAge;
+    for (const auto& peakFile : peakFiles)
+    {
+        if (peakFile.lastUsed >= oldestKept && totalBytes <= maxTotalBytes)
+            break;
+
+        if (peakFile.file.deleteFile())
+            totalBytes -= peakFile.size;
+    }
+}
+
+bool WaveformPeaks::generate(const juce::File& audioFile, const juce::File& peakFile,
+    juce::AudioFormatManager& formatManager,
+    const std::function<bool()>& shouldExit)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioFile));
+    if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0)
+        return false;
+
+    // the waveform only ever shows the first two channels
+    const int channels = (int)juce::jlimit(1u, 2u, reader->numChannels);
+    const juce::int64 length = reader->lengthInSamples;
+
+    // Finest level straight from the audio
+    const int finestSize = levelSizes[0];
+    const juce::int64 numFinest = (length + finestSize - 1) / finestSize;
+    std::vector<juce::int16> finest((size_t)(numFinest * channels * 2));
+
+    const int chunkSize = finestSize * 256;
+    juce::AudioBuffer<float> buffer(channels, chunkSize);
+    juce::int64 bucket = 0;
+
+    for (juce::int64 pos = 0; pos < length; pos += chunkSize)
+    {
+        if (shouldExit && shouldExit())
+            return false;
+
+        const int numSamples = (int)juce::jmin((juce::int64)chunkSize, length - pos);
+        reader->read(&buffer, 0, numSamples, pos, true, channels > 1);
+
+        for (int start = 0; start < numSamples; start += finestSize, ++bucket)
+        {
+            const int num = juce::jmin(finestSize, numSamples - start);
+            for (int ch = 0; ch < channels; ++ch)
+            {
+                auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(ch, start), num);
+                auto* out = finest.data() + (bucket * channels + ch) * 2;
+                out[0] = toPeakValue(range.getStart());
+                out[1] = toPeakValue(range.getEnd());
+            }
+        }
+    }
+
+    // Coarser levels are built from the finest one
+    std::vector<juce::int16> levelData[numLevels];
+    levelData[0] = std::move(finest);
+
+    for (int level = 1; level < numLevels; ++level)
+    {
+        const int ratio = levelSizes[level] / finestSize;
+        const juce::int64 numBuckets = (length + levelSizes[level] - 1) / levelSizes[level];
+        auto& data = levelData[level];
+        data.resize((size_t)(numBuckets * channels * 2));
+
+        for (juce::int64 b = 0; b < numBuckets; ++b)
+        {
+            const juce::int64 first = b * ratio;
+            const juce::int64 last = juce::jmin(first + ratio, numFinest);
+
+            for (int ch = 0; ch < channels; ++ch)
+            {
+                juce::int16 lo = 32767, hi = -32767;
+                for (juce::int64 f = first; f < last; ++f)
+                {
+                    const auto* in = levelData[0].data() + (f * channels + ch) * 2;
+                    lo = juce::jmin(lo, in[0]);
+                    hi = juce::jmax(hi, in[1]);
+                }
+
+                auto* out = data.data() + (b * channels + ch) * 2;
+                out[0] = lo;
+                out[1] = hi;
+            }
+        }
+    }
+
+    // Write to a temporary file and swap it in, so a half-written file is never mapped
+    peakFile.getParentDirectory().createDirectory();
+    juce::TemporaryFile temp(peakFile);
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+            return false;
+
+        out.writeInt(peakFileMagic);
+        out.writeInt(peakFileVersion);
+        out.writeDouble(reader->sampleRate);
+        out.writeInt64(length);
+        out.writeInt(channels);
+        out.writeInt(numLevels);
+
+        // level data starts after the level table, 16 byte aligned
+        juce::int64 offset = (headerSize + levelEntrySize * numLevels + 15) & ~(juce::int64)15;
+        for (int level = 0; level < numLevels; ++level)
+        {
+            out.writeInt(levelSizes[level]);
+            out.writeInt64((juce::int64)levelData[level].size() / (channels * 2));
+            out.writeInt64(offset);
+            offset += (juce::int64)(levelData[level].size() * sizeof(juce::int16));
+        }
+
+        while (out.getPosition() % 16 != 0)
+            out.writeByte(0);
+
+        for (int level = 0; level < numLevels; ++level)
+            out.write(levelData[level].data(), levelData[level].size() * sizeof(juce::int16));
+
+        out.flush();
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+std::unique_ptr<WaveformPeaks> WaveformPeaks::open(const juce::File& peakFile)
+{
+    if (!peakFile.existsAsFile())
+        return nullptr;
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(peakFile, juce::MemoryMappedFile::readOnly);
+    const auto* bytes = static_cast<const char*>(mapped->getData());
+    const auto size = (juce::int64)mapped->getSize();
+
+    if (bytes == nullptr || size < headerSize + levelEntrySize * numLevels)
+        return nullptr;
+
+    auto readInt = [bytes](juce::int64 at) { return (int)juce::ByteOrder::littleEndianInt(bytes + at); };
+    auto readInt64 = [bytes](juce::int64 at) { return (juce::int64)juce::ByteOrder::littleEndianInt64(bytes + at); };
+
+    if (readInt(0) != peakFileMagic || readInt(4) != peakFileVersion || readInt(28) != numLevels)
+        return nullptr;
+
+    // keeps it from being pruned while it is still wanted
+    peakFile.setLastModificationTime(juce::Time::getCurrentTime());
+
+    std::unique_ptr<WaveformPeaks> peaks(new WaveformPeaks());
+
+    const juce::int64 rateBits = readInt64(8);
+    std::memcpy(&peaks->sampleRate, &rateBits, sizeof(double));
+    peaks->lengthInSamples = readInt64(16);
+    peaks->numChannels = readInt(24);
+
+    if (peaks->sampleRate <= 0.0 || peaks->numChannels < 1 || peaks->numChannels > 2)
+        return nullptr;
+
+    for (int level = 0; level < numLevels; ++level)
+    {
+        const juce::int64 entry = headerSize + levelEntrySize * level;
+        auto& l = peaks->levels[level];
+        l.samplesPerBucket = readInt(entry);
+        l.numBuckets = readInt64(entry + 4);
+
+        const juce::int64 offset = readInt64(entry + 12);
+        const juce::int64 bytesNeeded = l.numBuckets * peaks->numChannels * 2 * (juce::int64)sizeof(juce::int16);
+
+        if (l.samplesPerBucket != levelSizes[level] || offset % 16 != 0 || offset + bytesNeeded > size)
+            return nullptr;
+
+        l.data = reinterpret_cast<const juce::int16*>(bytes + offset);
+    }
+
+    peaks->mappedFile = std::move(mapped);
+    return peaks;
+}
+
+const WaveformPeaks::Level& WaveformPeaks::chooseLevel(double samplesPerPixel) const noexcept
+{
+    for (int level = numLevels - 1; level > 0; --level)
+        if (levels[level].samplesPerBucket <= samplesPerPixel)
+            return levels[level];
+
+    return levels[0];
+}
+
+void WaveformPeaks::drawChannel(juce::Graphics& g, juce::Rectangle<int> area,
+    double startTimeSeconds, double endTimeSeconds,
+    int channel, float verticalZoomFactor) const
+{
+    if (area.isEmpty() || endTimeSeconds <= startTimeSeconds)
+        return;
+
+    channel = juce::jlimit(0, numChannels - 1, channel);
+
+    const double samplesPerPixel = (endTimeSeconds - startTimeSeconds) * sampleRate / area.getWidth();
+    const auto& level = chooseLevel(samplesPerPixel);
+    const double bucketsPerPixel = samplesPerPixel / level.samplesPerBucket;
+    const double firstBucket = startTimeSeconds * sampleRate / level.samplesPerBucket;
+
+    const float midY = (float)area.getCentreY();
+    const float halfHeight = area.getHeight() * 0.5f * verticalZoomFactor;
+
+    juce::RectangleList<float> columns;
+    columns.ensureStorageAllocated(area.getWidth());
+
+    for (int x = 0; x < area.getWidth(); ++x)
+    {
+        auto first = (juce::int64)(firstBucket + x * bucketsPerPixel);
+        auto last = juce::jmax(first + 1, (juce::int64)(firstBucket + (x + 1) * bucketsPerPixel));
+        first = juce::jlimit((juce::int64)0, level.numBuckets, first);
+        last = juce::jlimit((juce::int64)0, level.numBuckets, last);
+
+        if (first >= last)
+            continue;
+
+        int lo = 32767, hi = -32767;
+        for (auto b = first; b < last; ++b)
+        {
+            const auto* peak = level.data + (b * numChannels + channel) * 2;
+            lo = juce::jmin(lo, (int)peak[0]);
+            hi = juce::jmax(hi, (int)peak[1]);
+        }
+
+        const float top = juce::jmax((float)area.getY(), midY - hi / 32767.0f * halfHeight);
+        const float bottom = juce::jmin((float)area.getBottom(), midY - lo / 32767.0f * halfHeight);
+        columns.addWithoutMerging({ (float)(area.getX() + x), top, 1.0f, juce::jmax(1.0f, bottom - top) });
+    }
+
+    g.fillRectList(columns);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Min/max peaks of an audio file at several resolutions, stored in a peak file on disk.
+// The file is generated once on a background thread and memory-mapped afterwards,
+// so even an hour-long recording can be drawn as soon as it's loaded.
+// Peak files that haven't been opened for a while are deleted by pruneCache().
+//
+// Peak file layout (native little-endian byte order):
+//   header:  magic, version, sample rate, length in samples, channels, number of levels
+//   levels:  samples per bucket, number of buckets, byte offset of the level's data
+//   data:    for every bucket, for every channel, int16 min then int16 max
+class WaveformPeaks
+{
+public:
+	// Samples per bucket of each level, finest first
+	static constexpr int levelSizes[] = { 256, 4096, 65536 };
+	static constexpr int numLevels = (int)std::size(levelSizes);
+
+	// Where the peak file for this audio file lives; the name changes when the file's size or time changes
+	static juce::File getPeakFileFor(const juce::File& audioFile);
+
+	// Reads the whole audio file and writes its peak file. Slow; call from a background thread.
+	// Returns false if the audio can't be read or shouldExit returns true along the way.
+	static bool generate(const juce::File& audioFile, const juce::File& peakFile,
+		juce::AudioFormatManager& formatManager,
+		const std::function<bool()>& shouldExit);
+
+	// Maps an existing peak file and marks it as used; returns nullptr if it is missing or not valid
+	static std::unique_ptr<WaveformPeaks> open(const juce::File& peakFile);
+
+	// Deletes peak files not opened within maxAge, then the least recently used ones until the rest
+	// fit in maxTotalBytes. Lists the whole peak folder; call from a background thread.
+	static void pruneCache(juce::RelativeTime maxAge = juce::RelativeTime::days(90),
+		juce::int64 maxTotalBytes = (juce::int64)1024 * 1024 * 1024);
+
+	double getSampleRate() const noexcept { return sampleRate; }
+	juce::int64 getLengthInSamples() const noexcept { return lengthInSamples; }
+	int getNumChannels() const noexcept { return numChannels; }
+
+	// Same arguments as juce::AudioThumbnail::drawChannel, draws with the current colour
+	void drawChannel(juce::Graphics& g, juce::Rectangle<int> area,
+		double startTimeSeconds, double endTimeSeconds,
+		int channel, float verticalZoomFactor) const;
+
+private:
+	static juce::File getCacheDirectory();
+
+	struct Level
+	{
+		int samplesPerBucket = 0;
+		juce::int64 numBuckets = 0;
+		const juce::int16* data = nullptr;
+	};
+
+	WaveformPeaks() = default;
+
+	// coarsest level that still has at least one bucket per pixel
+	const Level& chooseLevel(double samplesPerPixel) const noexcept;
+
+	std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+	double sampleRate = 0.0;
+	juce::int64 lengthInSamples = 0;
+	int numChannels = 0;
+	Level levels[numLevels];
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformPeaks)
+};